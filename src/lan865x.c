@@ -11,6 +11,11 @@
 #include <linux/mdio.h>
 #include <linux/phy.h>
 #include <linux/of.h>
+#include <linux/math64.h>
+#include <linux/net_tstamp.h>
+#include <linux/ptp_clock_kernel.h>
+#include <linux/version.h>
+#include <net/pkt_sched.h>
 
 #include "oa_tc6.h"
 
@@ -34,6 +39,14 @@
 #define REG_MAC_ADDR_L		0x00010024
 #define REG_MAC_ADDR_H		0x00010025
 
+/* MAC 1588 timer */
+#define REG_MAC_TISUBN		0x0001006F
+#define REG_MAC_TSH		0x00010070
+#define REG_MAC_TSL		0x00010074
+#define REG_MAC_TN		0x00010075
+#define REG_MAC_TA		0x00010076
+#define REG_MAC_TI		0x00010077
+
 #define CCS_Q0_TX_CFG		0x000A0081
 #define CCS_Q0_RX_CFG		0x000A0082
 #define REG_CCS_DEVID		0x000A0094
@@ -51,15 +64,45 @@
 #define NW_DISABLE		0x0
 
 #define MAC_PROMISCUOUS_MODE	BIT(4)
-#define MAC_MULTICAST_MODE	BIT(6)
-#define MAC_UNICAST_MODE	BIT(7)
+#define MAC_MULTICAST_MODE	BIT(6)		/* Multicast hash enable */
+#define MAC_UNICAST_MODE	BIT(7)		/* Unicast hash enable */
+
+/* Specific address filters. Filter 2 holds the device address, filter 1 is
+ * disabled by the REG_MAC_ADDR_BO write, 3 and 4 are free.
+ */
+#define REG_MAC_SAB(n)		(0x00010022 + ((n) - 1) * 2)
+#define REG_MAC_SAT(n)		(0x00010023 + ((n) - 1) * 2)
+#define MAC_SPEC_ADDR_FIRST	3
+#define MAC_SPEC_ADDR_NUM	2
 
 #define LAN865X_REV_ID		GENMASK(3, 0)
 
+#define MAC_TISUBN_LSB		GENMASK(31, 24)
+#define MAC_TISUBN_MSB		GENMASK(15, 0)
+#define MAC_TA_ADJ		BIT(31)		/* Subtract */
+#define MAC_TA_ITDT		GENMASK(29, 0)
+#define MAC_TI_CNS		GENMASK(7, 0)
+
+/* The timer runs from the 25 MHz system clock */
+#define LAN865X_TIMER_INCR_NS	40
+#define LAN865X_PTP_MAX_ADJ	500000		/* ppb */
+
 #define TX_TIMEOUT		(4 * HZ)
 #define LAN865X_MSG_DEFAULT	\
 	(NETIF_MSG_PROBE | NETIF_MSG_IFUP | NETIF_MSG_IFDOWN | NETIF_MSG_LINK)
 
+/* Rx filter registers computed by ndo_set_rx_mode */
+struct lan865x_rx_mode {
+	u32 sab[MAC_SPEC_ADDR_NUM];
+	u32 sat[MAC_SPEC_ADDR_NUM];
+	u32 hash_lo;
+	u32 hash_hi;
+	u32 nw_config;
+	u8 exact;
+	u8 hashed;
+	bool promisc_fallback;	/* Promiscuous for lack of a unicast hash */
+};
+
 struct lan865x_priv {
 	struct net_device *netdev;
 	struct spi_device *spi;
@@ -78,6 +121,45 @@ struct lan865x_priv {
 	u8 rx_cut_thr_mode;
 	u8 cps;
 	u8 protected;
+	u8 bus_weight;
+	struct ptp_clock_info ptp_info;
+	struct ptp_clock *ptp_clock;
+	/* Serializes the accesses to the MAC timer */
+	struct mutex ptp_lock;
+	/* Timer increment in 2^-24 ns, restored after a MAC-PHY reset */
+	u64 ptp_incr;
+	struct work_struct rx_mode_work;
+	/* Serializes the filter writes of rx_mode_work and of a restore */
+	struct mutex rx_mode_lock;
+	struct lan865x_rx_mode rx_mode;
+	u32 filter_exact;
+	u32 filter_hashed;
+	u32 filter_promisc_fallbacks;
+	u8 hw_addr[ETH_ALEN];		/* Last written to the MAC */
+};
+
+enum lan865x_probe_phase {
+	LAN865X_PROBE_DT,
+	LAN865X_PROBE_RESET,
+	LAN865X_PROBE_CONFIG,
+	LAN865X_PROBE_PHY,
+	LAN865X_PROBE_MAC,
+	LAN865X_PROBE_PTP,
+	LAN865X_PROBE_REGISTER,
+	LAN865X_PROBE_PHASES,
+};
+
+/* Probe time per phase, for boards with a deadline for the network */
+struct lan865x_probe_time {
+	u64 start_ns;
+	u64 last_ns;
+	u32 us[LAN865X_PROBE_PHASES];
+};
+
+static const char lan865x_stats_strings[][ETH_GSTRING_LEN] = {
+	"mac_filter_exact",	/* Addresses in specific address filters */
+	"mac_filter_hashed",	/* Addresses in the hash filter */
+	"mac_filter_promisc_fallbacks",	/* Promiscuous mode forced on */
 };
 
 static struct {
@@ -118,6 +200,94 @@ static int lan865x_mdiobus_write(struct mii_bus *bus, int phy_id, int idx,
 	return 0;
 }
 
+/* The MMDs are mapped into the MAC-PHY's memory, an MMD register access is
+ * a single control transaction instead of the indirect access through the
+ * clause 22 MMD registers.
+ */
+static int lan865x_mmd_to_addr(int devnum, int regnum)
+{
+	int mms;
+
+	switch (devnum) {
+	case MDIO_MMD_PCS:
+		mms = OA_TC6_MMS_PCS;
+		break;
+	case MDIO_MMD_PMAPMD:
+		mms = OA_TC6_MMS_PMA_PMD;
+		break;
+	case MDIO_MMD_VEND2:
+		mms = OA_TC6_MMS_VEND2;
+		break;
+	case MDIO_MMD_AN:
+		mms = OA_TC6_MMS_AN;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	return mms << OA_TC6_MMS_SHIFT | (regnum & 0xFFFF);
+}
+
+static int lan865x_mdiobus_read_c45(struct mii_bus *bus, int phy_id,
+				    int devnum, int regnum)
+{
+	struct lan865x_priv *priv = bus->priv;
+	u32 regval;
+	int addr;
+
+	addr = lan865x_mmd_to_addr(devnum, regnum);
+	if (addr < 0)
+		return addr;
+
+	if (oa_tc6_read_register(priv->tc6, addr, &regval, 1))
+		return -ENODEV;
+
+	return regval;
+}
+
+static int lan865x_mdiobus_write_c45(struct mii_bus *bus, int phy_id,
+				     int devnum, int regnum, u16 regval)
+{
+	struct lan865x_priv *priv = bus->priv;
+	u32 value = regval;
+	int addr;
+
+	addr = lan865x_mmd_to_addr(devnum, regnum);
+	if (addr < 0)
+		return addr;
+
+	if (oa_tc6_write_register(priv->tc6, addr, &value, 1))
+		return -ENODEV;
+
+	return 0;
+}
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0)
+/* Clause 45 accesses come through the clause 22 ops before 6.3 */
+static int lan865x_mdiobus_read_compat(struct mii_bus *bus, int phy_id,
+				       int idx)
+{
+	if (idx & MII_ADDR_C45)
+		return lan865x_mdiobus_read_c45(bus, phy_id,
+						mdiobus_c45_devad(idx),
+						mdiobus_c45_regad(idx));
+
+	return lan865x_mdiobus_read(bus, phy_id, idx);
+}
+
+static int lan865x_mdiobus_write_compat(struct mii_bus *bus, int phy_id,
+					int idx, u16 regval)
+{
+	if (idx & MII_ADDR_C45)
+		return lan865x_mdiobus_write_c45(bus, phy_id,
+						 mdiobus_c45_devad(idx),
+						 mdiobus_c45_regad(idx),
+						 regval);
+
+	return lan865x_mdiobus_write(bus, phy_id, idx, regval);
+}
+#endif
+
 static int lan86xx_configure_plca(struct phy_device *phydev)
 {
 	struct lan865x_priv *priv = netdev_priv(phydev->attached_dev);
@@ -193,9 +363,18 @@ static int lan865x_phy_init(struct lan865x_priv *priv)
 	}
 
 	priv->mdiobus->phy_mask = ~(u32)BIT(1);
+	priv->mdiobus->irq[1] = oa_tc6_get_phy_irq(priv->tc6);
 	priv->mdiobus->priv = priv;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0)
+	priv->mdiobus->read = lan865x_mdiobus_read_compat;
+	priv->mdiobus->write = lan865x_mdiobus_write_compat;
+	priv->mdiobus->probe_capabilities = MDIOBUS_C22_C45;
+#else
 	priv->mdiobus->read = lan865x_mdiobus_read;
 	priv->mdiobus->write = lan865x_mdiobus_write;
+	priv->mdiobus->read_c45 = lan865x_mdiobus_read_c45;
+	priv->mdiobus->write_c45 = lan865x_mdiobus_write_c45;
+#endif
 	priv->mdiobus->name = "lan865x-mdiobus";
 	priv->mdiobus->parent = priv->dev;
 
@@ -224,16 +403,23 @@ static int lan865x_phy_init(struct lan865x_priv *priv)
 		return ret;
 	}
 	phy_attached_info(priv->phydev);
+	/* Suspended and resumed along with the MAC-PHY */
+	priv->phydev->mac_managed_pm = true;
 	return ret;
 }
 
 static int lan865x_set_hw_macaddr(struct net_device *netdev)
 {
 	u32 regval;
+	u32 regs[2];
 	bool ret;
 	struct lan865x_priv *priv = netdev_priv(netdev);
 	const u8 *mac = netdev->dev_addr;
 
+	/* Written in probe already when the interface is opened */
+	if (ether_addr_equal(priv->hw_addr, mac))
+		return 0;
+
 	ret = oa_tc6_read_register(priv->tc6, REG_MAC_NW_CTRL, &regval, 1);
 	if (ret)
 		goto error_mac;
@@ -242,15 +428,11 @@ static int lan865x_set_hw_macaddr(struct net_device *netdev)
 			netdev_warn(netdev, "Hardware must be disabled for MAC setting\n");
 		return -EBUSY;
 	}
-	/* MAC address setting */
-	regval = (mac[3] << 24) | (mac[2] << 16) | (mac[1] << 8) |
+	/* MAC address setting, REG_MAC_ADDR_H follows REG_MAC_ADDR_L */
+	regs[0] = (mac[3] << 24) | (mac[2] << 16) | (mac[1] << 8) |
 		mac[0];
-	ret = oa_tc6_write_register(priv->tc6, REG_MAC_ADDR_L, &regval, 1);
-	if (ret)
-		goto error_mac;
-
-	regval = (mac[5] << 8) | mac[4];
-	ret = oa_tc6_write_register(priv->tc6, REG_MAC_ADDR_H, &regval, 1);
+	regs[1] = (mac[5] << 8) | mac[4];
+	ret = oa_tc6_write_register(priv->tc6, REG_MAC_ADDR_L, regs, 2);
 	if (ret)
 		goto error_mac;
 
@@ -260,6 +442,7 @@ static int lan865x_set_hw_macaddr(struct net_device *netdev)
 	if (ret)
 		goto error_mac;
 
+	ether_addr_copy(priv->hw_addr, mac);
 	return 0;
 
 error_mac:
@@ -325,17 +508,288 @@ lan865x_get_drvinfo(struct net_device *netdev, struct ethtool_drvinfo *info)
 		dev_name(netdev->dev.parent), sizeof(info->bus_info));
 }
 
+static int lan865x_get_sset_count(struct net_device *netdev, int sset)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	if (sset != ETH_SS_STATS)
+		return -EOPNOTSUPP;
+
+	return ARRAY_SIZE(lan865x_stats_strings) +
+	       oa_tc6_get_sset_count(priv->tc6);
+}
+
+static void lan865x_get_strings(struct net_device *netdev, u32 sset, u8 *data)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	memcpy(data, lan865x_stats_strings, sizeof(lan865x_stats_strings));
+	oa_tc6_get_strings(priv->tc6, data + sizeof(lan865x_stats_strings));
+}
+
+static void lan865x_get_ethtool_stats(struct net_device *netdev,
+				      struct ethtool_stats *stats, u64 *data)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	*data++ = priv->filter_exact;
+	*data++ = priv->filter_hashed;
+	*data++ = priv->filter_promisc_fallbacks;
+	oa_tc6_get_ethtool_stats(priv->tc6, data);
+}
+
+static int lan865x_get_ts_info(struct net_device *netdev,
+			       struct ethtool_ts_info *info)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	info->so_timestamping = SOF_TIMESTAMPING_TX_SOFTWARE |
+				SOF_TIMESTAMPING_RX_SOFTWARE |
+				SOF_TIMESTAMPING_SOFTWARE |
+				SOF_TIMESTAMPING_TX_HARDWARE |
+				SOF_TIMESTAMPING_RX_HARDWARE |
+				SOF_TIMESTAMPING_RAW_HARDWARE;
+	info->phc_index = priv->ptp_clock ? ptp_clock_index(priv->ptp_clock) :
+					    -1;
+	info->tx_types = BIT(HWTSTAMP_TX_OFF) | BIT(HWTSTAMP_TX_ON);
+	info->rx_filters = BIT(HWTSTAMP_FILTER_NONE) |
+			   BIT(HWTSTAMP_FILTER_ALL);
+
+	return 0;
+}
+
 static const struct ethtool_ops lan865x_ethtool_ops = {
 	.get_drvinfo	= lan865x_get_drvinfo,
 	.get_msglevel	= lan865x_get_msglevel,
 	.set_msglevel	= lan865x_set_msglevel,
 	.get_link_ksettings = lan865x_get_link_ksettings,
 	.set_link_ksettings = lan865x_set_link_ksettings,
+	.get_sset_count	= lan865x_get_sset_count,
+	.get_strings	= lan865x_get_strings,
+	.get_ethtool_stats = lan865x_get_ethtool_stats,
+	.get_ts_info	= lan865x_get_ts_info,
 };
 
+static int lan865x_ptp_read_time(struct lan865x_priv *priv,
+				 struct timespec64 *ts)
+{
+	u32 regval[2];
+	u32 sec_h;
+	int ret;
+
+	ret = oa_tc6_read_register(priv->tc6, REG_MAC_TSH, &sec_h, 1);
+	if (ret)
+		return ret;
+
+	/* TSL and TN are adjacent, read them in one transaction */
+	ret = oa_tc6_read_register(priv->tc6, REG_MAC_TSL, regval, 2);
+	if (ret)
+		return ret;
+
+	ts->tv_sec = ((u64)(sec_h & 0xFFFF) << 32) | regval[0];
+	ts->tv_nsec = regval[1];
+
+	return 0;
+}
+
+static int lan865x_ptp_write_time(struct lan865x_priv *priv,
+				  const struct timespec64 *ts)
+{
+	u32 regval[2];
+	u32 sec_h;
+	int ret;
+
+	sec_h = upper_32_bits(ts->tv_sec) & 0xFFFF;
+	ret = oa_tc6_write_register(priv->tc6, REG_MAC_TSH, &sec_h, 1);
+	if (ret)
+		return ret;
+
+	regval[0] = lower_32_bits(ts->tv_sec);
+	regval[1] = ts->tv_nsec;
+
+	return oa_tc6_write_register(priv->tc6, REG_MAC_TSL, regval, 2);
+}
+
+static int lan865x_ptp_gettime64(struct ptp_clock_info *info,
+				 struct timespec64 *ts)
+{
+	struct lan865x_priv *priv = container_of(info, struct lan865x_priv,
+						 ptp_info);
+	int ret;
+
+	mutex_lock(&priv->ptp_lock);
+	ret = lan865x_ptp_read_time(priv, ts);
+	mutex_unlock(&priv->ptp_lock);
+
+	return ret;
+}
+
+static int lan865x_ptp_settime64(struct ptp_clock_info *info,
+				 const struct timespec64 *ts)
+{
+	struct lan865x_priv *priv = container_of(info, struct lan865x_priv,
+						 ptp_info);
+	int ret;
+
+	mutex_lock(&priv->ptp_lock);
+	ret = lan865x_ptp_write_time(priv, ts);
+	mutex_unlock(&priv->ptp_lock);
+
+	return ret;
+}
+
+/* Called with ptp_lock held */
+static int lan865x_ptp_write_incr(struct lan865x_priv *priv, u64 incr)
+{
+	u32 regval;
+	int ret;
+
+	regval = FIELD_PREP(MAC_TISUBN_MSB, (incr >> 8) & 0xFFFF) |
+		 FIELD_PREP(MAC_TISUBN_LSB, incr & 0xFF);
+	ret = oa_tc6_write_register(priv->tc6, REG_MAC_TISUBN, &regval, 1);
+	if (ret)
+		return ret;
+
+	regval = FIELD_PREP(MAC_TI_CNS, incr >> 24);
+	ret = oa_tc6_write_register(priv->tc6, REG_MAC_TI, &regval, 1);
+	if (ret)
+		return ret;
+
+	priv->ptp_incr = incr;
+	return 0;
+}
+
+/* The timer adds 40 ns plus a fraction in 2^-24 ns per clock cycle */
+static int lan865x_ptp_adjfine(struct ptp_clock_info *info, long scaled_ppm)
+{
+	struct lan865x_priv *priv = container_of(info, struct lan865x_priv,
+						 ptp_info);
+	u64 incr = (u64)LAN865X_TIMER_INCR_NS << 24;
+	bool neg = scaled_ppm < 0;
+	u64 diff;
+	int ret;
+
+	diff = div64_u64(incr * abs(scaled_ppm), 1000000ULL << 16);
+	incr = neg ? incr - diff : incr + diff;
+
+	mutex_lock(&priv->ptp_lock);
+	ret = lan865x_ptp_write_incr(priv, incr);
+	mutex_unlock(&priv->ptp_lock);
+
+	return ret;
+}
+
+static int lan865x_ptp_adjtime(struct ptp_clock_info *info, s64 delta)
+{
+	struct lan865x_priv *priv = container_of(info, struct lan865x_priv,
+						 ptp_info);
+	struct timespec64 ts;
+	u32 regval;
+	int ret;
+
+	mutex_lock(&priv->ptp_lock);
+	if (abs(delta) < NSEC_PER_SEC) {
+		/* Applied by the timer itself, without a read-modify-write
+		 * window.
+		 */
+		regval = FIELD_PREP(MAC_TA_ITDT, abs(delta));
+		if (delta < 0)
+			regval |= MAC_TA_ADJ;
+		ret = oa_tc6_write_register(priv->tc6, REG_MAC_TA, &regval, 1);
+	} else {
+		ret = lan865x_ptp_read_time(priv, &ts);
+		if (!ret) {
+			ts = ns_to_timespec64(timespec64_to_ns(&ts) + delta);
+			ret = lan865x_ptp_write_time(priv, &ts);
+		}
+	}
+	mutex_unlock(&priv->ptp_lock);
+
+	return ret;
+}
+
+static int lan865x_ptp_enable(struct ptp_clock_info *info,
+			      struct ptp_clock_request *rq, int on)
+{
+	return -EOPNOTSUPP;
+}
+
+static int lan865x_ptp_init(struct lan865x_priv *priv)
+{
+	struct timespec64 ts;
+	int ret;
+
+	mutex_init(&priv->ptp_lock);
+
+	/* Nominal rate and current TAI time to start with, PTP runs on TAI */
+	ret = lan865x_ptp_write_incr(priv, (u64)LAN865X_TIMER_INCR_NS << 24);
+	if (ret)
+		return ret;
+	ts = ktime_to_timespec64(ktime_get_clocktai());
+	ret = lan865x_ptp_write_time(priv, &ts);
+	if (ret)
+		return ret;
+
+	priv->ptp_info = (struct ptp_clock_info) {
+		.owner = THIS_MODULE,
+		.max_adj = LAN865X_PTP_MAX_ADJ,
+		.adjfine = lan865x_ptp_adjfine,
+		.adjtime = lan865x_ptp_adjtime,
+		.gettime64 = lan865x_ptp_gettime64,
+		.settime64 = lan865x_ptp_settime64,
+		.enable = lan865x_ptp_enable,
+	};
+	snprintf(priv->ptp_info.name, sizeof(priv->ptp_info.name), "%s %s",
+		 DRV_NAME, dev_name(&priv->spi->dev));
+
+	/* NULL if the kernel is built without PTP clock support. The
+	 * timestamps are still delivered without a clock, so neither case
+	 * fails the probe.
+	 */
+	priv->ptp_clock = ptp_clock_register(&priv->ptp_info, &priv->spi->dev);
+	if (IS_ERR(priv->ptp_clock)) {
+		dev_warn(&priv->spi->dev, "Failed to register PTP clock (%ld)\n",
+			 PTR_ERR(priv->ptp_clock));
+		priv->ptp_clock = NULL;
+	}
+
+	return 0;
+}
+
+/* The timer restarts from zero after a MAC-PHY reset. The TAI time is
+ * closer than that, ptp4l steps the rest.
+ */
+static int lan865x_ptp_restore(struct lan865x_priv *priv)
+{
+	struct timespec64 ts;
+	int ret;
+
+	mutex_lock(&priv->ptp_lock);
+	ret = lan865x_ptp_write_incr(priv, priv->ptp_incr);
+	if (!ret) {
+		ts = ktime_to_timespec64(ktime_get_clocktai());
+		ret = lan865x_ptp_write_time(priv, &ts);
+	}
+	mutex_unlock(&priv->ptp_lock);
+
+	return ret;
+}
+
+static void lan865x_ptp_deinit(struct lan865x_priv *priv)
+{
+	if (priv->ptp_clock)
+		ptp_clock_unregister(priv->ptp_clock);
+}
+
 static void lan865x_tx_timeout(struct net_device *netdev, unsigned int txqueue)
 {
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
 	netdev->stats.tx_errors++;
+	oa_tc6_request_recovery(priv->tc6);
 }
 
 static int lan865x_set_mac_address(struct net_device *netdev, void *addr)
@@ -351,75 +805,144 @@ static int lan865x_set_mac_address(struct net_device *netdev, void *addr)
 	return lan865x_set_hw_macaddr(netdev);
 }
 
-static u32 lan865x_hash(u8 addr[ETH_ALEN])
+static u32 lan865x_hash(const u8 addr[ETH_ALEN])
 {
 	return (ether_crc(ETH_ALEN, addr) >> 26) & 0x3f;
 }
 
+static void lan865x_hash_add(struct lan865x_rx_mode *mode, const u8 *addr)
+{
+	u32 bit_num = lan865x_hash(addr);
+
+	if (bit_num & 0x20)
+		mode->hash_hi |= BIT(bit_num & 0x1f);
+	else
+		mode->hash_lo |= BIT(bit_num & 0x1f);
+	mode->hashed++;
+}
+
+/* Use a free specific address filter, false if all of them are taken */
+static bool lan865x_spec_addr_add(struct lan865x_rx_mode *mode, const u8 *addr)
+{
+	if (mode->exact == MAC_SPEC_ADDR_NUM)
+		return false;
+
+	mode->sab[mode->exact] = (addr[3] << 24) | (addr[2] << 16) |
+				 (addr[1] << 8) | addr[0];
+	mode->sat[mode->exact] = (addr[5] << 8) | addr[4];
+	mode->exact++;
+
+	return true;
+}
+
+/* Called in atomic context, the registers are written by rx_mode_work */
 static void lan865x_set_multicast_list(struct net_device *netdev)
 {
 	struct lan865x_priv *priv = netdev_priv(netdev);
-	u32 regval = 0;
+	struct lan865x_rx_mode mode = { 0 };
+	struct netdev_hw_addr *ha;
 
 	if (netdev->flags & IFF_PROMISC) {
 		/* Enabling promiscuous mode */
-		regval |= MAC_PROMISCUOUS_MODE;
-		regval &= (~MAC_MULTICAST_MODE);
-		regval &= (~MAC_UNICAST_MODE);
-	} else if (netdev->flags & IFF_ALLMULTI) {
-		/* Enabling all multicast mode */
-		regval &= (~MAC_PROMISCUOUS_MODE);
-		regval |= MAC_MULTICAST_MODE;
-		regval &= (~MAC_UNICAST_MODE);
-	} else if (!netdev_mc_empty(netdev)) {
-		/* Enabling specific multicast addresses */
-		struct netdev_hw_addr *ha;
-		u32 hash_lo = 0;
-		u32 hash_hi = 0;
-
-		netdev_for_each_mc_addr(ha, netdev) {
-			u32 bit_num = lan865x_hash(ha->addr);
-			u32 mask = 1 << (bit_num & 0x1f);
-
-			if (bit_num & 0x20)
-				hash_hi |= mask;
-			else
-				hash_lo |= mask;
-		}
-		if (oa_tc6_write_register(priv->tc6, REG_MAC_HASHH, &hash_hi, 1)) {
-			if (netif_msg_timer(priv))
-				netdev_err(netdev, "Failed to write reg_hashh");
-			return;
-		}
-		if (oa_tc6_write_register(priv->tc6, REG_MAC_HASHL, &hash_lo, 1)) {
-			if (netif_msg_timer(priv))
-				netdev_err(netdev, "Failed to write reg_hashl");
-			return;
+		mode.nw_config = MAC_PROMISCUOUS_MODE;
+		goto out;
+	}
+
+	/* Exact matches first, the hash only for what doesn't fit */
+	netdev_for_each_uc_addr(ha, netdev) {
+		if (!lan865x_spec_addr_add(&mode, ha->addr)) {
+			lan865x_hash_add(&mode, ha->addr);
+			mode.nw_config |= MAC_UNICAST_MODE;
 		}
-		regval &= (~MAC_PROMISCUOUS_MODE);
-		regval &= (~MAC_MULTICAST_MODE);
-		regval |= MAC_UNICAST_MODE;
-	} else {
-		regval = 0;
-		/* enabling local mac address only */
-		if (oa_tc6_write_register(priv->tc6, REG_MAC_HASHH, &regval, 1)) {
-			if (netif_msg_timer(priv))
-				netdev_err(netdev, "Failed to write reg_hashh");
-			return;
+	}
+
+	if (netdev->flags & IFF_ALLMULTI) {
+		/* The hash is shared with the unicast addresses which didn't
+		 * fit, all bins set would pass every unicast frame. Go
+		 * promiscuous explicitly then, and count it.
+		 */
+		if (mode.nw_config & MAC_UNICAST_MODE) {
+			mode.nw_config = MAC_PROMISCUOUS_MODE;
+			mode.promisc_fallback = true;
+			goto out;
 		}
-		if (oa_tc6_write_register(priv->tc6, REG_MAC_HASHL, &regval, 1)) {
-			if (netif_msg_timer(priv))
-				netdev_err(netdev, "Failed to write reg_hashl");
-			return;
+		/* Enabling all multicast mode */
+		mode.hash_lo = 0xFFFFFFFF;
+		mode.hash_hi = 0xFFFFFFFF;
+		mode.nw_config |= MAC_MULTICAST_MODE;
+		goto out;
+	}
+
+	netdev_for_each_mc_addr(ha, netdev) {
+		if (!lan865x_spec_addr_add(&mode, ha->addr)) {
+			lan865x_hash_add(&mode, ha->addr);
+			mode.nw_config |= MAC_MULTICAST_MODE;
 		}
-		regval &= (~MAC_PROMISCUOUS_MODE);
-		regval &= (~MAC_MULTICAST_MODE);
-		regval &= (~MAC_UNICAST_MODE);
 	}
-	if (oa_tc6_write_register(priv->tc6, REG_MAC_NW_CONFIG, &regval, 1)) {
+
+out:
+	priv->rx_mode = mode;
+	schedule_work(&priv->rx_mode_work);
+}
+
+static void lan865x_write_rx_mode(struct lan865x_priv *priv)
+{
+	struct net_device *netdev = priv->netdev;
+	struct lan865x_rx_mode mode;
+	u32 regs[2];
+
+	/* Taken before the snapshot, the last writer writes the latest mode */
+	mutex_lock(&priv->rx_mode_lock);
+	netif_addr_lock_bh(netdev);
+	mode = priv->rx_mode;
+	netif_addr_unlock_bh(netdev);
+
+	/* Writing the bottom register disables a filter, writing the top one
+	 * enables it again. Both are written in one control transaction.
+	 */
+	for (u8 i = 0; i < MAC_SPEC_ADDR_NUM; i++) {
+		regs[0] = i < mode.exact ? mode.sab[i] : 0;
+		regs[1] = mode.sat[i];
+		if (oa_tc6_write_register(priv->tc6,
+					  REG_MAC_SAB(MAC_SPEC_ADDR_FIRST + i),
+					  regs, i < mode.exact ? 2 : 1))
+			goto err_write;
+	}
+	/* REG_MAC_HASHH follows REG_MAC_HASHL */
+	regs[0] = mode.hash_lo;
+	regs[1] = mode.hash_hi;
+	if (oa_tc6_write_register(priv->tc6, REG_MAC_HASHL, regs, 2)) {
+		if (netif_msg_timer(priv))
+			netdev_err(netdev, "Failed to write reg_hash");
+		goto out;
+	}
+	if (oa_tc6_write_register(priv->tc6, REG_MAC_NW_CONFIG, &mode.nw_config,
+				  1)) {
 		if (netif_msg_timer(priv))
-			netdev_err(netdev, "Failed to enable promiscuous mode");
+			netdev_err(netdev, "Failed to write reg_nw_config");
+		goto out;
 	}
+
+	priv->filter_exact = mode.exact;
+	priv->filter_hashed = mode.hashed;
+	if (mode.promisc_fallback)
+		priv->filter_promisc_fallbacks++;
+	mutex_unlock(&priv->rx_mode_lock);
+	return;
+
+err_write:
+	if (netif_msg_timer(priv))
+		netdev_err(netdev, "Failed to write specific address filter");
+out:
+	mutex_unlock(&priv->rx_mode_lock);
+}
+
+static void lan865x_rx_mode_work(struct work_struct *work)
+{
+	struct lan865x_priv *priv = container_of(work, struct lan865x_priv,
+						 rx_mode_work);
+
+	lan865x_write_rx_mode(priv);
 }
 
 static netdev_tx_t lan865x_send_packet(struct sk_buff *skb,
@@ -430,6 +953,23 @@ static netdev_tx_t lan865x_send_packet(struct sk_buff *skb,
 	return oa_tc6_send_eth_pkt(priv->tc6, skb);
 }
 
+static int lan865x_ioctl(struct net_device *netdev, struct ifreq *rq, int cmd)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	if (!netif_running(netdev))
+		return -EINVAL;
+
+	switch (cmd) {
+	case SIOCSHWTSTAMP:
+		return oa_tc6_hwtstamp_set(priv->tc6, rq);
+	case SIOCGHWTSTAMP:
+		return oa_tc6_hwtstamp_get(priv->tc6, rq);
+	default:
+		return phy_mii_ioctl(priv->phydev, rq, cmd);
+	}
+}
+
 static int lan865x_hw_disable(struct lan865x_priv *priv)
 {
 	u32 regval = NW_DISABLE;
@@ -452,7 +992,7 @@ static int lan865x_net_close(struct net_device *netdev)
 		return ret;
 	}
 
-	netif_stop_queue(netdev);
+	netif_tx_stop_all_queues(netdev);
 
 	return 0;
 }
@@ -491,19 +1031,59 @@ static int lan865x_net_open(struct net_device *netdev)
 			netdev_err(netdev, "Failed to enable hardware\n");
 		return -ENODEV;
 	}
-	netif_start_queue(netdev);
+	netif_tx_start_all_queues(netdev);
+
+	return 0;
+}
+
+static int lan865x_set_features(struct net_device *netdev,
+				netdev_features_t features)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	if ((netdev->features ^ features) & NETIF_F_RXCSUM)
+		oa_tc6_set_rx_csum(priv->tc6, !!(features & NETIF_F_RXCSUM));
+	if ((netdev->features ^ features) & NETIF_F_RXHASH)
+		oa_tc6_set_rx_hash(priv->tc6, !!(features & NETIF_F_RXHASH));
 
 	return 0;
 }
 
+static int lan865x_setup_tc(struct net_device *netdev, enum tc_setup_type type,
+			    void *type_data)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	switch (type) {
+	case TC_SETUP_QDISC_MQPRIO:
+		return oa_tc6_setup_mqprio(priv->tc6, type_data);
+	case TC_SETUP_QDISC_ETF:
+		return oa_tc6_setup_etf(priv->tc6, type_data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static u16 lan865x_select_queue(struct net_device *netdev, struct sk_buff *skb,
+				struct net_device *sb_dev)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+
+	return oa_tc6_select_queue(priv->tc6, skb, sb_dev);
+}
+
 static const struct net_device_ops lan865x_netdev_ops = {
 	.ndo_open		= lan865x_net_open,
 	.ndo_stop		= lan865x_net_close,
 	.ndo_start_xmit		= lan865x_send_packet,
+	.ndo_select_queue	= lan865x_select_queue,
 	.ndo_set_rx_mode	= lan865x_set_multicast_list,
 	.ndo_set_mac_address	= lan865x_set_mac_address,
 	.ndo_tx_timeout		= lan865x_tx_timeout,
 	.ndo_validate_addr	= eth_validate_addr,
+	.ndo_eth_ioctl		= lan865x_ioctl,
+	.ndo_set_features	= lan865x_set_features,
+	.ndo_setup_tc		= lan865x_setup_tc,
 };
 
 static int lan865x_get_dt_data(struct lan865x_priv *priv)
@@ -595,18 +1175,147 @@ static int lan865x_get_dt_data(struct lan865x_priv *priv)
 		dev_err(&spi->dev, "bad value in oa-protected property");
 		return -EINVAL;
 	}
+	/* Optional, share of the SPI bus if the controller has other MAC-PHYs */
+	ret = of_property_read_u8(spi->dev.of_node, "oa-bus-weight", &priv->bus_weight);
+	if (ret < 0)
+		priv->bus_weight = 1;
+	if (priv->bus_weight < 1 || priv->bus_weight > 16) {
+		dev_err(&spi->dev, "bad value in oa-bus-weight property");
+		return -EINVAL;
+	}
 
 	return 0;
 }
 
+/* Must be done before the data transfer is configured */
+static int lan865x_config_queues(struct lan865x_priv *priv)
+{
+	/* CCS_Q0_RX_CFG follows CCS_Q0_TX_CFG */
+	u32 regs[2] = { CCS_Q0_TX_CFG_32, CCS_Q0_RX_CFG_32 };
+
+	if (priv->cps != 32)
+		return 0;
+
+	return oa_tc6_write_register(priv->tc6, CCS_Q0_TX_CFG, regs, 2);
+}
+
+/* The MAC-PHY was reset by oa_tc6 and has to be configured again. Called by
+ * the tc6 task.
+ */
+static int lan865x_restore_early(struct net_device *netdev)
+{
+	return lan865x_config_queues(netdev_priv(netdev));
+}
+
+static int lan865x_restore(struct net_device *netdev)
+{
+	struct lan865x_priv *priv = netdev_priv(netdev);
+	int ret;
+
+	/* PHY driver configuration and interrupt mask, under the PHY lock
+	 * against the phylib state machine and the PHY interrupt handler.
+	 */
+	mutex_lock(&priv->phydev->lock);
+	ret = phy_init_hw(priv->phydev);
+	if (!ret)
+		ret = lan865x_phy_fixup(priv->phydev);
+	mutex_unlock(&priv->phydev->lock);
+	if (ret)
+		return ret;
+
+	/* The MAC forgot it */
+	eth_zero_addr(priv->hw_addr);
+	ret = lan865x_set_hw_macaddr(netdev);
+	if (ret)
+		return ret;
+
+	lan865x_write_rx_mode(priv);
+
+	ret = lan865x_ptp_restore(priv);
+	if (ret)
+		return ret;
+
+	if (netif_running(netdev))
+		return lan865x_hw_enable(priv);
+
+	return 0;
+}
+
+static const struct oa_tc6_recovery_ops lan865x_recovery_ops = {
+	.restore_early = lan865x_restore_early,
+	.restore = lan865x_restore,
+};
+
+static int lan865x_suspend(struct device *dev)
+{
+	struct lan865x_priv *priv = dev_get_drvdata(dev);
+	struct net_device *netdev = priv->netdev;
+
+	if (netif_running(netdev)) {
+		netif_device_detach(netdev);
+		lan865x_hw_disable(priv);
+	}
+	cancel_work_sync(&priv->rx_mode_work);
+
+	/* The PHY in power down is the lowest power mode short of the
+	 * supply being cut.
+	 */
+	phy_stop(priv->phydev);
+	phy_suspend(priv->phydev);
+
+	return oa_tc6_suspend(priv->tc6);
+}
+
+/* Battery powered nodes wake up often to send a few frames, so instead of
+ * the probe the cached configuration is replayed.
+ */
+static int lan865x_resume(struct device *dev)
+{
+	struct lan865x_priv *priv = dev_get_drvdata(dev);
+	struct net_device *netdev = priv->netdev;
+	u64 start_ns = ktime_get_ns();
+	int ret;
+
+	ret = oa_tc6_resume(priv->tc6);
+	if (ret)
+		return ret;
+
+	phy_start(priv->phydev);
+	if (netif_running(netdev))
+		netif_device_attach(netdev);
+
+	if (netif_msg_ifup(priv))
+		netdev_info(netdev, "Resumed in %llu us\n",
+			    div_u64(ktime_get_ns() - start_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+
+static DEFINE_SIMPLE_DEV_PM_OPS(lan865x_pm_ops, lan865x_suspend,
+				lan865x_resume);
+
+static void lan865x_probe_phase_done(struct lan865x_probe_time *pt,
+				     enum lan865x_probe_phase phase)
+{
+	u64 now_ns = ktime_get_ns();
+
+	pt->us[phase] = div_u64(now_ns - pt->last_ns, NSEC_PER_USEC);
+	pt->last_ns = now_ns;
+}
+
 static int lan865x_probe(struct spi_device *spi)
 {
+	struct lan865x_probe_time pt = { };
 	struct net_device *netdev;
+	struct device_node *np;
 	struct lan865x_priv *priv;
-	u32 regval;
 	int ret;
 
-	netdev = alloc_etherdev(sizeof(struct lan865x_priv));
+	pt.start_ns = ktime_get_ns();
+	pt.last_ns = pt.start_ns;
+
+	netdev = alloc_etherdev_mq(sizeof(struct lan865x_priv),
+				   OA_TC6_MAX_TX_QUEUES);
 	if (!netdev)
 		return -ENOMEM;
 
@@ -615,6 +1324,8 @@ static int lan865x_probe(struct spi_device *spi)
 	priv->spi = spi;
 	priv->msg_enable = netif_msg_init(debug.msg_enable,
 					  LAN865X_MSG_DEFAULT);
+	INIT_WORK(&priv->rx_mode_work, lan865x_rx_mode_work);
+	mutex_init(&priv->rx_mode_lock);
 	spi_set_drvdata(spi, priv);
 	SET_NETDEV_DEV(netdev, &spi->dev);
 
@@ -624,28 +1335,34 @@ static int lan865x_probe(struct spi_device *spi)
 
 	spi->rt = true;
 	spi_setup(spi);
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_DT);
 
 	priv->tc6 = oa_tc6_init(spi, netdev);
 	if (!priv->tc6) {
 		ret = -ENOMEM;
 		goto error_oa_tc6_init;
 	}
-
-	if (priv->cps == 32) {
-		regval = CCS_Q0_TX_CFG_32;
-		ret = oa_tc6_write_register(priv->tc6, CCS_Q0_TX_CFG, &regval, 1);
+	oa_tc6_set_sched_weight(priv->tc6, priv->bus_weight);
+	oa_tc6_set_recovery_ops(priv->tc6, &lan865x_recovery_ops);
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_RESET);
+
+	/* Optional, forward frames directly to the other port of a gateway */
+	np = of_parse_phandle(spi->dev.of_node, "oa-forward-peer", 0);
+	if (np) {
+		ret = oa_tc6_enable_forwarding(priv->tc6, np);
+		of_node_put(np);
 		if (ret)
-			return ret;
-
-		regval = CCS_Q0_RX_CFG_32;
-		ret = oa_tc6_write_register(priv->tc6, CCS_Q0_RX_CFG, &regval, 1);
-		if (ret)
-			return ret;
+			goto err_macphy_config;
 	}
 
+	ret = lan865x_config_queues(priv);
+	if (ret)
+		goto err_macphy_config;
+
 	if (oa_tc6_configure(priv->tc6, priv->cps, priv->protected, priv->tx_cut_thr_mode,
 			     priv->rx_cut_thr_mode))
 		goto err_macphy_config;
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_CONFIG);
 
 	ret = lan865x_phy_init(priv);
 	if (ret)
@@ -654,6 +1371,7 @@ static int lan865x_probe(struct spi_device *spi)
 	ret = lan865x_phy_fixup(priv->phydev);
 	if (ret)
 		goto error_phy_fixup;
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_PHY);
 
 	if (device_get_ethdev_address(&spi->dev, netdev))
 		eth_hw_addr_random(netdev);
@@ -664,12 +1382,26 @@ static int lan865x_probe(struct spi_device *spi)
 			dev_err(&spi->dev, "Failed to configure MAC");
 		goto error_set_mac;
 	}
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_MAC);
+
+	ret = lan865x_ptp_init(priv);
+	if (ret) {
+		if (netif_msg_probe(priv))
+			dev_err(&spi->dev, "Failed to initialize PTP timer");
+		goto error_ptp;
+	}
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_PTP);
 
 	netdev->if_port = IF_PORT_10BASET;
 	netdev->irq = spi->irq;
 	netdev->netdev_ops = &lan865x_netdev_ops;
 	netdev->watchdog_timeo = TX_TIMEOUT;
 	netdev->ethtool_ops = &lan865x_ethtool_ops;
+	netdev->priv_flags |= IFF_UNICAST_FLT;
+	netdev->hw_features |= NETIF_F_RXCSUM | NETIF_F_RXHASH;
+	netdev->features |= NETIF_F_RXCSUM | NETIF_F_RXHASH;
+	oa_tc6_set_rx_csum(priv->tc6, true);
+	oa_tc6_set_rx_hash(priv->tc6, true);
 	ret = register_netdev(netdev);
 	if (ret) {
 		if (netif_msg_probe(priv))
@@ -679,9 +1411,21 @@ static int lan865x_probe(struct spi_device *spi)
 	}
 
 	phy_start(priv->phydev);
+	lan865x_probe_phase_done(&pt, LAN865X_PROBE_REGISTER);
+
+	if (netif_msg_probe(priv))
+		dev_info(&spi->dev,
+			 "Probed in %llu us: dt %u, reset %u, config %u, phy %u, mac %u, ptp %u, register %u\n",
+			 div_u64(pt.last_ns - pt.start_ns, NSEC_PER_USEC),
+			 pt.us[LAN865X_PROBE_DT], pt.us[LAN865X_PROBE_RESET],
+			 pt.us[LAN865X_PROBE_CONFIG], pt.us[LAN865X_PROBE_PHY],
+			 pt.us[LAN865X_PROBE_MAC], pt.us[LAN865X_PROBE_PTP],
+			 pt.us[LAN865X_PROBE_REGISTER]);
 	return 0;
 
 error_netdev_register:
+	lan865x_ptp_deinit(priv);
+error_ptp:
 error_phy_fixup:
 error_set_mac:
 	phy_disconnect(priv->phydev);
@@ -699,11 +1443,18 @@ static void lan865x_remove(struct spi_device *spi)
 {
 	struct lan865x_priv *priv = spi_get_drvdata(spi);
 
+	/* No tx timeout can request a recovery after this, and with the tc6
+	 * task parked none can run lan865x_restore() on the PHY torn down
+	 * below.
+	 */
+	unregister_netdev(priv->netdev);
+	cancel_work_sync(&priv->rx_mode_work);
+	oa_tc6_suspend(priv->tc6);
 	phy_stop(priv->phydev);
 	phy_disconnect(priv->phydev);
 	mdiobus_unregister(priv->mdiobus);
 	mdiobus_free(priv->mdiobus);
-	unregister_netdev(priv->netdev);
+	lan865x_ptp_deinit(priv);
 	oa_tc6_deinit(priv->tc6);
 	free_netdev(priv->netdev);
 }
@@ -728,6 +1479,9 @@ MODULE_DEVICE_TABLE(acpi, lan865x_acpi_ids);
 static struct spi_driver lan865x_driver = {
 	.driver = {
 		.name = DRV_NAME,
+		/* Several MAC-PHYs are brought up in parallel */
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.pm = pm_sleep_ptr(&lan865x_pm_ops),
 #ifdef CONFIG_OF
 		.of_match_table = lan865x_dt_ids,
 #endif
@@ -10,16 +10,41 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/phy.h>
+#include <linux/version.h>
 
 #define PHY_ID_LAN867X_REVB1 0x0007C162
 #define PHY_ID_LAN867X_REVC0 0x0007C163
 #define PHY_ID_LAN867X_REVC1 0x0007C164
 #define PHY_ID_LAN865X_REVB 0x0007C1B3
 
+#define LAN86XX_REG_STS1 0x0018
 #define LAN867X_REG_STS2 0x0019
+#define LAN86XX_REG_IMSK1 0x001C
+#define LAN86XX_REG_IMSK2 0x001D
+
+#define LAN86XX_STS1_PSTC BIT(13)	/* PLCA Status Changed */
+#define LAN86XX_IMSK_ALL 0xFFFF
+
+#define LAN86XX_REG_PLCA_CTRL0 0xCA01
+#define LAN86XX_PLCA_EN BIT(15)
+#define LAN86XX_REG_PLCA_STS 0xCA03
+#define LAN86XX_PLCA_PST BIT(15)	/* PLCA Status, beacons seen */
 
 #define LAN867x_RESET_COMPLETE_STS BIT(11)
 
+/* PLCA state last read on a PLCA status interrupt */
+struct lan86xx_priv {
+	bool plca_enabled;
+	bool plca_beacons;
+	u64 plca_changes;	/* Beacon status changes seen */
+};
+
+static const char lan86xx_stats_strings[][ETH_GSTRING_LEN] = {
+	"plca_enabled",
+	"plca_beacons",
+	"plca_status_changes",
+};
+
 #define LAN867X_REG_STRAP0		0x12
 #define LAN867X_IF_TYPE			GENMASK(8, 7)
 #define LAN867X_RMII_IF_TYPE		0x1
@@ -415,8 +440,151 @@ static int lan867x_revc_config_init(struct phy_device *phydev)
 	return lan867x_revc_setup_cfgparam(phydev);
 }
 
+static int lan86xx_ack_interrupt(struct phy_device *phydev)
+{
+	int ret;
+
+	/* Write one to clear */
+	ret = phy_read_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_STS1);
+	if (ret <= 0)
+		return ret;
+
+	return phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_STS1, ret);
+}
+
+/* PLCA coming up or going down is the only event on a link which otherwise
+ * never changes. The other status 1 and 2 events stay masked.
+ */
+static int lan86xx_config_intr(struct phy_device *phydev)
+{
+	int ret;
+
+	if (phydev->interrupts == PHY_INTERRUPT_ENABLED) {
+		ret = lan86xx_ack_interrupt(phydev);
+		if (ret)
+			return ret;
+		ret = phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_IMSK2,
+				    LAN86XX_IMSK_ALL);
+		if (ret)
+			return ret;
+		return phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_IMSK1,
+				     LAN86XX_IMSK_ALL & ~LAN86XX_STS1_PSTC);
+	}
+
+	ret = phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_IMSK1,
+			    LAN86XX_IMSK_ALL);
+	if (ret)
+		return ret;
+	ret = phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_IMSK2,
+			    LAN86XX_IMSK_ALL);
+	if (ret)
+		return ret;
+
+	return lan86xx_ack_interrupt(phydev);
+}
+
+static irqreturn_t lan86xx_handle_interrupt(struct phy_device *phydev)
+{
+	int sts;
+
+	sts = phy_read_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_STS1);
+	if (sts < 0) {
+		phy_error(phydev);
+		return IRQ_HANDLED;
+	}
+	if (!(sts & LAN86XX_STS1_PSTC))
+		return IRQ_NONE;
+
+	if (phy_write_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_STS1, sts)) {
+		phy_error(phydev);
+		return IRQ_HANDLED;
+	}
+
+	phy_trigger_machine(phydev);
+
+	return IRQ_HANDLED;
+}
+
+/* The internal PHY of the LAN865x is discovered through clause 22, which
+ * would make phylib reach its MMDs indirectly, 3 to 4 control transactions
+ * on SPI per access. The MAC-PHY maps them into its memory, one control
+ * transaction each.
+ */
+static int lan865x_phy_read_mmd(struct phy_device *phydev, int devnum,
+				u16 regnum)
+{
+	struct mii_bus *bus = phydev->mdio.bus;
+	int addr = phydev->mdio.addr;
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0)
+	return __mdiobus_read(bus, addr, mdiobus_c45_addr(devnum, regnum));
+#else
+	return __mdiobus_c45_read(bus, addr, devnum, regnum);
+#endif
+}
+
+static int lan865x_phy_write_mmd(struct phy_device *phydev, int devnum,
+				 u16 regnum, u16 val)
+{
+	struct mii_bus *bus = phydev->mdio.bus;
+	int addr = phydev->mdio.addr;
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0)
+	return __mdiobus_write(bus, addr, mdiobus_c45_addr(devnum, regnum),
+			       val);
+#else
+	return __mdiobus_c45_write(bus, addr, devnum, regnum, val);
+#endif
+}
+
+static int lan86xx_probe(struct phy_device *phydev)
+{
+	phydev->priv = devm_kzalloc(&phydev->mdio.dev,
+				    sizeof(struct lan86xx_priv), GFP_KERNEL);
+	if (!phydev->priv)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static int lan86xx_get_sset_count(struct phy_device *phydev)
+{
+	return ARRAY_SIZE(lan86xx_stats_strings);
+}
+
+static void lan86xx_get_strings(struct phy_device *phydev, u8 *data)
+{
+	memcpy(data, lan86xx_stats_strings, sizeof(lan86xx_stats_strings));
+}
+
+static void lan86xx_get_stats(struct phy_device *phydev,
+			      struct ethtool_stats *stats, u64 *data)
+{
+	struct lan86xx_priv *priv = phydev->priv;
+
+	data[0] = priv->plca_enabled;
+	data[1] = priv->plca_beacons;
+	data[2] = priv->plca_changes;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+static int lan86xx_get_plca_status(struct phy_device *phydev,
+				   struct phy_plca_status *plca_st)
+{
+	struct lan86xx_priv *priv = phydev->priv;
+
+	plca_st->pst = priv->plca_beacons;
+
+	return 0;
+}
+#endif
+
 static int lan86xx_read_status(struct phy_device *phydev)
 {
+	struct lan86xx_priv *priv = phydev->priv;
+	bool beacons;
+	int ret;
+
 	/* The phy has some limitations, namely:
 	 *  - always reports link up
 	 *  - only supports 10MBit half duplex
@@ -427,6 +595,32 @@ static int lan86xx_read_status(struct phy_device *phydev)
 	phydev->speed = SPEED_10;
 	phydev->autoneg = AUTONEG_DISABLE;
 
+	/* Only read on an interrupt, the PHY isn't polled then. A node
+	 * without beacons falls back to CSMA/CD, so this isn't a link down.
+	 */
+	if (!phy_interrupt_is_valid(phydev))
+		return 0;
+
+	ret = phy_read_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_PLCA_CTRL0);
+	if (ret < 0)
+		return ret;
+	priv->plca_enabled = !!(ret & LAN86XX_PLCA_EN);
+	if (!priv->plca_enabled) {
+		priv->plca_beacons = false;
+		return 0;
+	}
+
+	ret = phy_read_mmd(phydev, MDIO_MMD_VEND2, LAN86XX_REG_PLCA_STS);
+	if (ret < 0)
+		return ret;
+	beacons = !!(ret & LAN86XX_PLCA_PST);
+	if (beacons != priv->plca_beacons) {
+		priv->plca_beacons = beacons;
+		priv->plca_changes++;
+		phydev_dbg(phydev, beacons ? "PLCA beacons detected\n" :
+			   "PLCA enabled, no beacons\n");
+	}
+
 	return 0;
 }
 
@@ -435,25 +629,65 @@ static struct phy_driver microchip_t1s_driver[] = {
 		PHY_ID_MATCH_EXACT(PHY_ID_LAN867X_REVB1),
 		.name               = "LAN867X Rev.B1",
 		.config_init        = lan867x_revb1_config_init,
+		.probe              = lan86xx_probe,
 		.read_status        = lan86xx_read_status,
+		.get_sset_count     = lan86xx_get_sset_count,
+		.get_strings        = lan86xx_get_strings,
+		.get_stats          = lan86xx_get_stats,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+		.get_plca_status    = lan86xx_get_plca_status,
+#endif
+		.config_intr        = lan86xx_config_intr,
+		.handle_interrupt   = lan86xx_handle_interrupt,
 	},
 	{
 		PHY_ID_MATCH_EXACT(PHY_ID_LAN867X_REVC0),
 		.name               = "LAN867X Rev.C0",
 		.config_init        = lan867x_revc_config_init,
+		.probe              = lan86xx_probe,
 		.read_status        = lan86xx_read_status,
+		.get_sset_count     = lan86xx_get_sset_count,
+		.get_strings        = lan86xx_get_strings,
+		.get_stats          = lan86xx_get_stats,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+		.get_plca_status    = lan86xx_get_plca_status,
+#endif
+		.config_intr        = lan86xx_config_intr,
+		.handle_interrupt   = lan86xx_handle_interrupt,
 	},
 	{
 		PHY_ID_MATCH_EXACT(PHY_ID_LAN867X_REVC1),
 		.name               = "LAN867X Rev.C1",
 		.config_init        = lan867x_revc_config_init,
+		.probe              = lan86xx_probe,
 		.read_status        = lan86xx_read_status,
+		.get_sset_count     = lan86xx_get_sset_count,
+		.get_strings        = lan86xx_get_strings,
+		.get_stats          = lan86xx_get_stats,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+		.get_plca_status    = lan86xx_get_plca_status,
+#endif
+		.config_intr        = lan86xx_config_intr,
+		.handle_interrupt   = lan86xx_handle_interrupt,
 	},
 	{
 		PHY_ID_MATCH_EXACT(PHY_ID_LAN865X_REVB),
 		.name               = "LAN865X Rev.B Internal Phy",
 		.config_init        = lan865x_revb_config_init,
+		.probe              = lan86xx_probe,
 		.read_status        = lan86xx_read_status,
+		.get_sset_count     = lan86xx_get_sset_count,
+		.get_strings        = lan86xx_get_strings,
+		.get_stats          = lan86xx_get_stats,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+		.get_plca_status    = lan86xx_get_plca_status,
+#endif
+		.read_mmd           = lan865x_phy_read_mmd,
+		.write_mmd          = lan865x_phy_write_mmd,
+		.suspend            = genphy_suspend,
+		.resume             = genphy_resume,
+		.config_intr        = lan86xx_config_intr,
+		.handle_interrupt   = lan86xx_handle_interrupt,
 	},
 };
 
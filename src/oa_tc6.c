@@ -7,11 +7,62 @@
 
 #include <linux/etherdevice.h>
 #include <linux/bitfield.h>
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
 #include <linux/interrupt.h>
-#include "oa_tc6.h"
+#include <linux/irq.h>
+#include <linux/irqdomain.h>
+#include <linux/math64.h>
+#include <linux/net_tstamp.h>
+#include <linux/phy.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/version.h>
+#include <net/checksum.h>
+#include <net/devlink.h>
+#include <net/pkt_sched.h>
+#include "oa_tc6_frame.h"
+#include "oa_tc6_fwd.h"
+#include "oa_tc6_recovery.h"
+#include "oa_tc6_sched.h"
+#include "oa_tc6_task.h"
+#include "oa_tc6_trace.h"
+
+/* Data transfers always go from spi_tx_buf to spi_rx_buf and only differ in
+ * their number of chunks, so the tc6 task keeps one prepared message per
+ * chunk count. Where the SPI core supports it the message is optimized once
+ * so that spi_sync() skips the validation and the controller can keep its
+ * per message setup.
+ */
+struct oa_tc6_data_msg {
+	struct spi_message msg;
+	struct spi_transfer xfer;
+	bool optimized;
+};
 
-static int oa_tc6_spi_transfer(struct spi_device *spi, u8 *ptx, u8 *prx,
-			       u16 len)
+static int oa_tc6_spi_sync(struct oa_tc6 *tc6, struct spi_message *msg,
+			   u8 *ptx, u8 *prx, u16 len)
+{
+	u32 duration_ns;
+	u64 ts_ns;
+	int ret;
+
+	ts_ns = ktime_get_ns();
+	ret = spi_sync(tc6->spi, msg);
+	duration_ns = ktime_get_ns() - ts_ns;
+
+	tc6->bus_stats.spi_bytes += len;
+	tc6->bus_stats.spi_busy_ns += duration_ns;
+	if (current == tc6->tc6_task)
+		oa_tc6_sched_charge(tc6, len);
+
+	if (unlikely(READ_ONCE(tc6->trace_enabled)) && !ret)
+		oa_tc6_trace_record(tc6, ptx, prx, len, ts_ns, duration_ns);
+
+	return ret;
+}
+
+static int oa_tc6_spi_transfer(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u16 len)
 {
 	struct spi_transfer xfer = {
 		.tx_buf = ptx,
@@ -23,116 +74,53 @@ static int oa_tc6_spi_transfer(struct spi_device *spi, u8 *ptx, u8 *prx,
 	spi_message_init(&msg);
 	spi_message_add_tail(&xfer, &msg);
 
-	return spi_sync(spi, &msg);
+	return oa_tc6_spi_sync(tc6, &msg, ptx, prx, len);
 }
 
-static bool oa_tc6_get_parity(u32 p)
+static void oa_tc6_data_msg_release(struct oa_tc6_data_msg *dmsg)
 {
-	bool parity = true;
-
-	/* This function returns an odd parity bit */
-	while (p) {
-		parity = !parity;
-		p = p & (p - 1);
-	}
-	return parity;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+	if (dmsg->optimized)
+		spi_unoptimize_message(&dmsg->msg);
+#endif
+	dmsg->optimized = false;
+	dmsg->xfer.len = 0;
 }
 
-static void oa_tc6_prepare_ctrl_buf(struct oa_tc6 *tc6, u32 addr, u32 val[],
-				    u8 len, bool wnr, u8 *buf, bool ctrl_prot)
+static void oa_tc6_data_msgs_release(struct oa_tc6 *tc6)
 {
-	u32 hdr;
-
-	/* Prepare the control header with the required details */
-	hdr = FIELD_PREP(CTRL_HDR_DNC, 0) |
-	      FIELD_PREP(CTRL_HDR_WNR, wnr) |
-	      FIELD_PREP(CTRL_HDR_AID, 0) |
-	      FIELD_PREP(CTRL_HDR_MMS, addr >> 16) |
-	      FIELD_PREP(CTRL_HDR_ADDR, addr) |
-	      FIELD_PREP(CTRL_HDR_LEN, len - 1);
-	hdr |= FIELD_PREP(CTRL_HDR_P, oa_tc6_get_parity(hdr));
-	*(u32 *)&buf[0] = cpu_to_be32(hdr);
-
-	if (wnr) {
-		for (u8 i = 0; i < len; i++) {
-			u16 pos;
-
-			if (!ctrl_prot) {
-				/* Send the value to be written followed by the
-				 * header.
-				 */
-				pos = TC6_HDR_SIZE + (i * TC6_HDR_SIZE);
-				*(u32 *)&buf[pos] = cpu_to_be32(val[i]);
-			} else {
-				/* If protected then send complemented value
-				 * also followed by actual value.
-				 */
-				pos = TC6_HDR_SIZE + (i * (TC6_HDR_SIZE * 2));
-				*(u32 *)&buf[pos] = cpu_to_be32(val[i]);
-				pos = (TC6_HDR_SIZE * 2) +
-				      (i * (TC6_HDR_SIZE * 2));
-				*(u32 *)&buf[pos] = cpu_to_be32(~val[i]);
-			}
-		}
-	}
+	for (u8 i = 0; i < OA_TC6_MAX_CHUNKS; i++)
+		oa_tc6_data_msg_release(&tc6->data_msgs[i]);
 }
 
-static int oa_tc6_check_control(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u8 len,
-				bool wnr, bool ctrl_prot)
+/* Transfers len bytes of chunks from spi_tx_buf into spi_rx_buf. Only called
+ * by the tc6 task. The message for a chunk count is rebuilt when the chunk
+ * payload size changed since it was last used.
+ */
+static int oa_tc6_spi_data_transfer(struct oa_tc6 *tc6, u16 len)
 {
-	/* 1st 4 bytes of rx chunk data can be discarded */
-	u32 rx_hdr = *(u32 *)&prx[TC6_HDR_SIZE];
-	u32 tx_hdr = *(u32 *)&ptx[0];
-	u32 rx_data_complement;
-	u32 tx_data;
-	u32 rx_data;
-	u16 pos;
-
-	/* If tx hdr and echoed hdr are not equal then there might be an issue
-	 * with the connection between SPI host and MAC-PHY. Here this case is
-	 * considered as MAC-PHY is not connected.
-	 */
-	if (tx_hdr != rx_hdr)
-		return -ENODEV;
-
-	if (wnr) {
-		if (!ctrl_prot) {
-			/* In case of ctrl write, both tx data & echoed
-			 * data are compared for the error.
-			 */
-			for (u8 i = 0; i < len; i++) {
-				pos = TC6_HDR_SIZE + (i * TC6_HDR_SIZE);
-				tx_data = *(u32 *)&ptx[pos];
-				pos = (TC6_HDR_SIZE * 2) + (i * TC6_HDR_SIZE);
-				rx_data = *(u32 *)&prx[pos];
-				if (tx_data != rx_data)
-					return -ENODEV;
-			}
-			goto exit;
-		} else {
-			goto check_rx_data;
-		}
-	} else {
-		if (ctrl_prot)
-			goto check_rx_data;
-		else
-			goto exit;
+	u16 chunk_size = tc6->cps + TC6_HDR_SIZE;
+	struct oa_tc6_data_msg *dmsg;
+	u16 count = len / chunk_size;
+
+	if (unlikely(!count || count > OA_TC6_MAX_CHUNKS || len % chunk_size))
+		return oa_tc6_spi_transfer(tc6, tc6->spi_tx_buf,
+					   tc6->spi_rx_buf, len);
+
+	dmsg = &tc6->data_msgs[count - 1];
+	if (unlikely(dmsg->xfer.len != len)) {
+		oa_tc6_data_msg_release(dmsg);
+		dmsg->xfer.tx_buf = tc6->spi_tx_buf;
+		dmsg->xfer.rx_buf = tc6->spi_rx_buf;
+		dmsg->xfer.len = len;
+		spi_message_init_with_transfers(&dmsg->msg, &dmsg->xfer, 1);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+		dmsg->optimized = !spi_optimize_message(tc6->spi, &dmsg->msg);
+#endif
 	}
 
-check_rx_data:
-	/* In case of ctrl read or ctrl write in protected mode, the rx data and
-	 * the complement of rx data are compared for the error.
-	 */
-	for (u8 i = 0; i < len; i++) {
-		pos = (TC6_HDR_SIZE * 2) + (i * (TC6_HDR_SIZE * 2));
-		rx_data = *(u32 *)&prx[pos];
-		pos = (TC6_HDR_SIZE * 3) + (i * (TC6_HDR_SIZE * 2));
-		rx_data_complement = *(u32 *)&prx[pos];
-		if (rx_data != ~rx_data_complement)
-			return -ENODEV;
-	}
-exit:
-	return 0;
+	return oa_tc6_spi_sync(tc6, &dmsg->msg, tc6->spi_tx_buf,
+			       tc6->spi_rx_buf, len);
 }
 
 int oa_tc6_perform_ctrl(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
@@ -141,13 +129,9 @@ int oa_tc6_perform_ctrl(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
 	u8 *tx_buf;
 	u8 *rx_buf;
 	u16 size;
-	u16 pos;
 	int ret;
 
-	if (ctrl_prot)
-		size = (TC6_HDR_SIZE * 2) + (len * (TC6_HDR_SIZE * 2));
-	else
-		size = (TC6_HDR_SIZE * 2) + (len * TC6_HDR_SIZE);
+	size = oa_tc6_ctrl_size(len, ctrl_prot);
 
 	tx_buf = kzalloc(size, GFP_KERNEL);
 	if (!tx_buf)
@@ -163,10 +147,15 @@ int oa_tc6_perform_ctrl(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
 	oa_tc6_prepare_ctrl_buf(tc6, addr, val, len, wnr, tx_buf, ctrl_prot);
 
 	/* Perform SPI transfer */
-	ret = oa_tc6_spi_transfer(tc6->spi, tx_buf, rx_buf, size);
+	ret = oa_tc6_spi_transfer(tc6, tx_buf, rx_buf, size);
 	if (ret)
 		goto err_spi_xfer;
 
+	tc6->bus_stats.ctrl_xfers++;
+	tc6->bus_stats.ctrl_bytes += size;
+	if (ctrl_prot)
+		tc6->bus_stats.ctrl_prot_bytes += len * TC6_HDR_SIZE;
+
 	/* In case of reset write, the echoed control command doesn't have any
 	 * valid data. So no need to check for error.
 	 */
@@ -178,19 +167,8 @@ int oa_tc6_perform_ctrl(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
 			goto err_check_ctrl;
 	}
 
-	if (!wnr) {
-		/* Copy read data from the rx data in case of ctrl read */
-		for (u8 i = 0; i < len; i++) {
-			if (!ctrl_prot) {
-				pos = (TC6_HDR_SIZE * 2) + (i * TC6_HDR_SIZE);
-				val[i] = be32_to_cpu(*(u32 *)&rx_buf[pos]);
-			} else {
-				pos = (TC6_HDR_SIZE * 2) +
-				       (i * (TC6_HDR_SIZE * 2));
-				val[i] = be32_to_cpu(*(u32 *)&rx_buf[pos]);
-			}
-		}
-	}
+	if (!wnr)
+		oa_tc6_copy_ctrl_data(rx_buf, val, len, ctrl_prot);
 
 err_check_ctrl:
 err_spi_xfer:
@@ -200,30 +178,14 @@ err_rx_buf_kzalloc:
 	return ret;
 }
 
-static u16 oa_tc6_prepare_empty_chunk(struct oa_tc6 *tc6, u8 *buf, u8 cp_count)
-{
-	u32 hdr;
-
-	/* Prepare empty chunks used for getting interrupt information or if
-	 * receive data available.
-	 */
-	for (u8 i = 0; i < cp_count; i++) {
-		hdr = 0;
-		hdr |= FIELD_PREP(DATA_HDR_DNC, 1);
-		hdr |= FIELD_PREP(DATA_HDR_P, oa_tc6_get_parity(hdr));
-		hdr = cpu_to_be32(hdr);
-		*(u32 *)&buf[i * (tc6->cps + TC6_HDR_SIZE)] = hdr;
-		memset(&buf[TC6_HDR_SIZE + (i * (tc6->cps + TC6_HDR_SIZE))], 0,
-		       tc6->cps);
-	}
-
-	return cp_count * (tc6->cps + TC6_HDR_SIZE);
-}
-
-static void oa_tc6_rx_eth_ready(struct oa_tc6 *tc6)
+void oa_tc6_rx_eth_ready(struct oa_tc6 *tc6)
 {
 	struct sk_buff *skb = NULL;
 
+	/* Frames for stations behind the paired port bypass the stack */
+	if (tc6->fwd && oa_tc6_fwd_rx(tc6))
+		return;
+
 	/* Send the received ethernet packet to network layer */
 	skb = netdev_alloc_skb(tc6->netdev, tc6->rxd_bytes + NET_IP_ALIGN);
 	if (!skb) {
@@ -233,14 +195,49 @@ static void oa_tc6_rx_eth_ready(struct oa_tc6 *tc6)
 		skb_reserve(skb, NET_IP_ALIGN);
 		memcpy(skb_put(skb, tc6->rxd_bytes), &tc6->eth_rx_buf[0],
 		       tc6->rxd_bytes);
+		if (tc6->rx_ts_valid && tc6->hwts_rx_en)
+			skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(tc6->rx_ts);
 		skb->protocol = eth_type_trans(skb, tc6->netdev);
+		if (tc6->rx_hash_type != PKT_HASH_TYPE_NONE)
+			skb_set_hash(skb, tc6->rx_hash, tc6->rx_hash_type);
+		/* CHECKSUM_COMPLETE covers what follows the ethernet header */
+		if (tc6->rx_csum_valid) {
+			skb->csum = csum_sub(tc6->rx_csum,
+					     csum_partial(tc6->eth_rx_buf,
+							  ETH_HLEN, 0));
+			skb->ip_summed = CHECKSUM_COMPLETE;
+		}
 		tc6->netdev->stats.rx_packets++;
 		tc6->netdev->stats.rx_bytes += tc6->rxd_bytes;
 		netif_rx(skb);
 	}
 }
 
-static int oa_tc6_process_exst(struct oa_tc6 *tc6)
+/* Deliver the tx timestamp captured in TTSCA to the frame waiting for it */
+static void oa_tc6_tx_ts_done(struct oa_tc6 *tc6)
+{
+	struct skb_shared_hwtstamps hwts = {};
+	struct sk_buff *skb;
+	u32 regval[2];
+
+	skb = xchg(&tc6->tx_ts_skb, NULL);
+	if (!skb)
+		return;
+
+	if (oa_tc6_read_register(tc6, OA_TC6_TTSCAH, regval, 2)) {
+		netdev_err(tc6->netdev, "TTSCA register read failed.\n");
+	} else {
+		hwts.hwtstamp = ns_to_ktime((u64)regval[0] * NSEC_PER_SEC +
+					    regval[1]);
+		skb_tstamp_tx(skb, &hwts);
+	}
+	dev_kfree_skb_any(skb);
+}
+
+#define OA_TC6_STS0_ERRORS	(CDPE | TXFCSE | HDRE | LOFE | RXBOE | TXBUE | \
+				 TXBOE | TXPE)
+
+int oa_tc6_process_exst(struct oa_tc6 *tc6)
 {
 	u32 regval;
 	int ret;
@@ -250,6 +247,8 @@ static int oa_tc6_process_exst(struct oa_tc6 *tc6)
 		netdev_err(tc6->netdev, "STS0 register read failed.\n");
 		return ret;
 	}
+	if (regval & TTSCAA)
+		oa_tc6_tx_ts_done(tc6);
 	if (regval & TXPE)
 		netdev_err(tc6->netdev, "Transmit protocol error\n");
 	if (regval & TXBOE)
@@ -265,157 +264,413 @@ static int oa_tc6_process_exst(struct oa_tc6 *tc6)
 	if (regval & TXFCSE)
 		netdev_err(tc6->netdev, "Transmit Frame Check Sequence Error\n");
 	ret = oa_tc6_write_register(tc6, OA_TC6_STS0, &regval, 1);
-	if (ret)
+	if (ret) {
 		netdev_err(tc6->netdev, "STS0 register write failed.\n");
-	return ret;
+		return ret;
+	}
+
+	/* Cleared by the PHY driver acknowledging the PHY interrupt status */
+	if ((regval & PHYINT) && tc6->phy_irq > 0)
+		handle_nested_irq(tc6->phy_irq);
+
+	/* A tx timestamp capture alone doesn't disturb the data transfer */
+	if (!(regval & OA_TC6_STS0_ERRORS))
+		return FTR_OK;
+
+	tc6->rx_err = (regval & LOFE) ? OA_TC6_ERR_LOFE : OA_TC6_ERR_STATUS;
+	return FTR_ERR;
 }
 
-static int oa_tc6_process_rx_chunks(struct oa_tc6 *tc6, u8 *buf, u16 len)
+/* Data chunks of a receive burst, from the interrupt until RCA is back to
+ * 0, taken into the average. Continuous traffic is cut off at this.
+ */
+#define OA_TC6_RX_BURST_MAX	(2 * OA_TC6_MAX_CHUNKS)
+
+/* Number of empty chunks to clock for receiving when needed are known to be
+ * waiting. RCA is only known from a previous footer, so after an interrupt
+ * it takes a read of one chunk to learn it, and it is capped at 31 chunks.
+ * A burst usually carries about as many chunks as the recent ones, so the
+ * read is extended to the rest of the average burst and the chunks beyond
+ * the received data just come back empty.
+ */
+static u8 oa_tc6_rx_read_ahead(struct oa_tc6 *tc6, u8 needed)
 {
-	u8 cp_count;
-	u32 ftr;
-	u8 *payload;
-	u16 ebo;
-	u16 sbo;
+	u8 ahead_max = clamp_t(u8, READ_ONCE(tc6->rx_ahead_max), 1,
+			       OA_TC6_MAX_CHUNKS);
+	u16 expected = DIV_ROUND_UP(tc6->rx_burst_avg, 8);
 
-	/* Calculate the number of chunks received */
-	cp_count = len / (tc6->cps + TC6_FTR_SIZE);
+	if (expected <= tc6->rx_burst_chunks)
+		return needed;
 
-	for (u8 i = 0; i < cp_count; i++) {
-		/* Get the footer and payload */
-		ftr = *(u32 *)&buf[tc6->cps + (i * (tc6->cps + TC6_FTR_SIZE))];
-		ftr = be32_to_cpu(ftr);
-		payload = &buf[(i * (tc6->cps + TC6_FTR_SIZE))];
-		/* Check for footer parity error */
-		if (oa_tc6_get_parity(ftr)) {
-			netdev_err(tc6->netdev, "Footer: Parity error\n");
-			goto err_exit;
-		}
-		/* If EXST set in the footer then read STS0 register to get the
-		 * status information.
-		 */
-		if (FIELD_GET(DATA_FTR_EXST, ftr)) {
-			if (oa_tc6_process_exst(tc6))
-				netdev_err(tc6->netdev, "Failed to process EXST\n");
-			goto err_exit;
-		}
-		if (FIELD_GET(DATA_FTR_HDRB, ftr)) {
-			netdev_err(tc6->netdev, "Footer: Received header bad\n");
-			goto err_exit;
-		}
-		if (!FIELD_GET(DATA_FTR_SYNC, ftr)) {
-			netdev_err(tc6->netdev, "Footer: Configuration unsync\n");
-			goto err_exit;
-		}
-		/* If Frame Drop is set, indicates that the MAC has detected a
-		 * condition for which the SPI host should drop the received
-		 * ethernet frame.
-		 */
-		if (FIELD_GET(DATA_FTR_FD, ftr) && FIELD_GET(DATA_FTR_EV, ftr)) {
-			netdev_warn(tc6->netdev, "Footer: Frame drop\n");
-			if (FIELD_GET(DATA_FTR_SV, ftr)) {
-				goto start_new_frame;
+	return max_t(u8, needed, min_t(u16, expected - tc6->rx_burst_chunks,
+				       ahead_max));
+}
+
+/* Account a receive transfer of chunks of which needed were known to be
+ * waiting, and take the burst into the average once RCA is back to 0.
+ */
+static void oa_tc6_rx_read_ahead_done(struct oa_tc6 *tc6, u8 needed,
+				      u8 chunks, u8 data_chunks)
+{
+	struct oa_tc6_bus_stats *stats = &tc6->bus_stats;
+
+	if (chunks > needed) {
+		stats->rx_ahead_xfers++;
+		if (data_chunks > needed)
+			stats->rx_ahead_saved++;
+		else
+			stats->rx_ahead_wasted++;
+	}
+
+	tc6->rx_burst_chunks = min_t(u16, tc6->rx_burst_chunks + data_chunks,
+				     OA_TC6_RX_BURST_MAX);
+	if (!tc6->rca)
+		tc6->rx_burst_avg = tc6->rx_burst_avg -
+				    (tc6->rx_burst_avg >> 3) +
+				    tc6->rx_burst_chunks;
+}
+
+/* Account a data transfer of chunks, of which the first tx_chunks carry the
+ * tx frame from tx_pos of eth_tx_buf and data_chunks came back with rx data.
+ */
+static void oa_tc6_account_data_xfer(struct oa_tc6 *tc6, u8 chunks,
+				     u16 tx_pos, u8 tx_chunks, u8 data_chunks)
+{
+	struct oa_tc6_bus_stats *stats = &tc6->bus_stats;
+	u16 sent = (tx_pos / (tc6->cps + TC6_HDR_SIZE)) * tc6->cps;
+	u16 payload;
+
+	stats->data_xfers++;
+	if (tx_chunks) {
+		payload = min_t(u16, tx_chunks * tc6->cps,
+				tc6->tx_skb->len - sent);
+		stats->tx_payload_bytes += payload;
+		stats->tx_pad_bytes += (tx_chunks * tc6->cps) - payload;
+		stats->hdr_ftr_bytes += tx_chunks * TC6_HDR_SIZE;
+	}
+	stats->hdr_ftr_bytes += data_chunks * TC6_FTR_SIZE;
+	stats->empty_bytes += (chunks - max(tx_chunks, data_chunks)) *
+			      (tc6->cps + TC6_FTR_SIZE);
+}
+
+/* Launch times are only met within this window with the SPI pipeline delay
+ * only known from the previous frames.
+ */
+#define OA_TC6_TXTIME_WINDOW_NS		20000
+/* A stalled frame, e.g. waiting for credits, doesn't tell much about the
+ * pipeline delay.
+ */
+#define OA_TC6_TXTIME_MAX_DELAY_NS	(10 * NSEC_PER_MSEC)
+
+static enum hrtimer_restart oa_tc6_txtime_expired(struct hrtimer *timer)
+{
+	struct oa_tc6 *tc6 = container_of(timer, struct oa_tc6, txtime_timer);
+
+	tc6->tx_flag = true;
+	wake_up_interruptible(&tc6->tc6_wq);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Wire time of a byte on the 10 Mb/s bus. The MAC-PHY returns the credit of
+ * a chunk once it went out on the wire, so that is the earliest credits can
+ * come back; with PLCA the node also waits for its transmit opportunity.
+ */
+#define OA_TC6_WIRE_NS_PER_BYTE		800
+/* Credit polls after a stall, the MAC-PHY interrupt still comes later */
+#define OA_TC6_TXC_POLLS		4
+
+static enum hrtimer_restart oa_tc6_txc_expired(struct hrtimer *timer)
+{
+	struct oa_tc6 *tc6 = container_of(timer, struct oa_tc6, txc_timer);
+
+	tc6->txc_poll = true;
+	wake_up_interruptible(&tc6->tc6_wq);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Poll the credits once the chunks still needed, at most a transfer of
+ * them, can have gone out on the wire.
+ */
+static void oa_tc6_txc_predict(struct oa_tc6 *tc6)
+{
+	u8 chunks = clamp_t(u8, tc6->txc_needed, 1, OA_TC6_MAX_CHUNKS);
+
+	hrtimer_start(&tc6->txc_timer,
+		      ns_to_ktime((u64)chunks * tc6->cps *
+				  OA_TC6_WIRE_NS_PER_BYTE),
+		      HRTIMER_MODE_REL);
+}
+
+/* The tx frame waits for credits */
+static void oa_tc6_txc_stall(struct oa_tc6 *tc6)
+{
+	if (tc6->txc_stall_start_ns)
+		return;
+
+	tc6->txc_stall_start_ns = ktime_get_ns();
+	tc6->txc_polls = 0;
+	tc6->tx_stats.txc_stalls++;
+	oa_tc6_txc_predict(tc6);
+}
+
+static void oa_tc6_txc_unstall(struct oa_tc6 *tc6)
+{
+	if (!tc6->txc_stall_start_ns)
+		return;
+
+	tc6->tx_stats.txc_stall_ns += ktime_get_ns() -
+				       tc6->txc_stall_start_ns;
+	tc6->txc_stall_start_ns = 0;
+	hrtimer_try_to_cancel(&tc6->txc_timer);
+}
+
+/* Read the credits from BUFSTS, a control read of 12 bytes instead of a
+ * chunk transfer, instead of waiting for the interrupt. Returns true if
+ * there are credits.
+ */
+static bool oa_tc6_txc_poll(struct oa_tc6 *tc6)
+{
+	u32 regval;
+
+	tc6->txc_poll = false;
+	if (!tc6->txc_stall_start_ns)
+		return false;
+
+	tc6->tx_stats.txc_polls++;
+	if (oa_tc6_read_register(tc6, OA_TC6_BUFSTS, &regval, 1))
+		return false;
+
+	tc6->txc = FIELD_GET(TXC, regval);
+	tc6->rca = FIELD_GET(RCA, regval);
+	if (tc6->txc)
+		return true;
+
+	tc6->tx_stats.txc_polls_empty++;
+	if (++tc6->txc_polls < OA_TC6_TXC_POLLS)
+		oa_tc6_txc_predict(tc6);
+
+	return false;
+}
+
+/* Take the next frame at a frame boundary: the head of the highest priority
+ * queue which is due. A frame with a launch time is due the measured
+ * pipeline delay ahead, so that its last chunk reaches the MAC-PHY on time,
+ * and doesn't block the other queues before.
+ */
+static struct sk_buff *oa_tc6_tx_dequeue(struct oa_tc6 *tc6)
+{
+	u8 txtime_queues = READ_ONCE(tc6->txtime_queues);
+	struct sk_buff_head *txq;
+	u64 hold_ns = U64_MAX;
+	struct sk_buff *skb;
+	u64 release_ns;
+	u64 now_ns = 0;
+
+	for (int q = tc6->tx_queues - 1; q >= 0; q--) {
+		txq = &tc6->tx_q[q];
+		spin_lock_bh(&txq->lock);
+		skb = skb_peek(txq);
+		if (skb && (txtime_queues & BIT(q)) && skb->tstamp) {
+			if (!now_ns)
+				now_ns = ktime_get_clocktai_ns();
+			release_ns = ktime_to_ns(skb->tstamp) -
+				     tc6->txtime_delay_ns;
+			if (now_ns < release_ns) {
+				hold_ns = min(hold_ns, release_ns);
+				tc6->txtime_held |= BIT(q);
+				skb = NULL;
 			} else {
-				if (tc6->rx_eth_started) {
-					tc6->rxd_bytes = 0;
-					tc6->rx_eth_started = false;
-					tc6->netdev->stats.rx_dropped++;
-				}
-				continue;
+				/* Late unless it waited for its release */
+				tc6->tx_launch_ns = ktime_to_ns(skb->tstamp);
+				tc6->tx_release_ns = tc6->txtime_held & BIT(q) ?
+						     release_ns : now_ns;
+				tc6->txtime_held &= ~BIT(q);
 			}
 		}
-		/* Check for data valid */
-		if (FIELD_GET(DATA_FTR_DV, ftr)) {
-			/* Check whether both start valid and end valid are in a
-			 * single chunk payload means a single chunk payload may
-			 * contain an entire ethernet frame.
-			 */
-			if (FIELD_GET(DATA_FTR_SV, ftr) &&
-			    FIELD_GET(DATA_FTR_EV, ftr)) {
-				sbo = FIELD_GET(DATA_FTR_SWO, ftr) * 4;
-				ebo = FIELD_GET(DATA_FTR_EBO, ftr) + 1;
-				if (ebo <= sbo) {
-					memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes],
-					       &payload[0], ebo);
-					tc6->rxd_bytes += ebo;
-					oa_tc6_rx_eth_ready(tc6);
-					tc6->rxd_bytes = 0;
-					memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes],
-					       &payload[sbo], tc6->cps - sbo);
-					tc6->rxd_bytes += (tc6->cps - sbo);
-					goto exit;
-				} else {
-					memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes],
-					       &payload[sbo], ebo - sbo);
-					tc6->rxd_bytes += (ebo - sbo);
-					oa_tc6_rx_eth_ready(tc6);
-					tc6->rxd_bytes = 0;
-					goto exit;
-				}
-			}
-start_new_frame:
-			/* Check for start valid to start capturing the incoming
-			 * ethernet frame.
-			 */
-			if (FIELD_GET(DATA_FTR_SV, ftr) && !tc6->rx_eth_started) {
-				tc6->rxd_bytes = 0;
-				tc6->rx_eth_started = true;
-				sbo = FIELD_GET(DATA_FTR_SWO, ftr) * 4;
-				memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes],
-				       &payload[sbo], tc6->cps - sbo);
-				tc6->rxd_bytes += (tc6->cps - sbo);
-				goto exit;
-			}
-
-			/* Check for end valid and calculate the copy length */
-			if (tc6->rx_eth_started) {
-				if (FIELD_GET(DATA_FTR_EV, ftr))
-					ebo = FIELD_GET(DATA_FTR_EBO, ftr) + 1;
-				else
-					ebo = tc6->cps;
-
-				memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes],
-				       &payload[0], ebo);
-				tc6->rxd_bytes += ebo;
-				if (FIELD_GET(DATA_FTR_EV, ftr)) {
-					/* If End Valid set then send the
-					 * received ethernet frame to n/w.
-					 */
-					oa_tc6_rx_eth_ready(tc6);
-					tc6->rxd_bytes = 0;
-					tc6->rx_eth_started = false;
-				}
-			}
+		if (skb)
+			__skb_unlink(skb, txq);
+		spin_unlock_bh(&txq->lock);
+
+		if (skb) {
+			/* Pairs with the barrier in oa_tc6_send_eth_pkt() */
+			smp_mb();
+			if (__netif_subqueue_stopped(tc6->netdev, q))
+				netif_wake_subqueue(tc6->netdev, q);
+			return skb;
 		}
-
-exit:
-		tc6->txc = FIELD_GET(DATA_FTR_TXC, ftr);
-		tc6->rca = FIELD_GET(DATA_FTR_RCA, ftr);
 	}
-	return FTR_OK;
 
-err_exit:
-	if (tc6->rx_eth_started) {
-		tc6->rxd_bytes = 0;
-		tc6->rx_eth_started = false;
-		tc6->netdev->stats.rx_dropped++;
+	if (hold_ns != U64_MAX)
+		hrtimer_start(&tc6->txtime_timer, ns_to_ktime(hold_ns),
+			      HRTIMER_MODE_ABS);
+
+	return NULL;
+}
+
+static bool oa_tc6_tx_pending(struct oa_tc6 *tc6)
+{
+	for (u8 q = 0; q < tc6->tx_queues; q++)
+		if (!skb_queue_empty_lockless(&tc6->tx_q[q]))
+			return true;
+
+	return false;
+}
+
+static void oa_tc6_txtime_done(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_tx_stats *stats = &tc6->tx_stats;
+	u64 now_ns = ktime_get_clocktai_ns();
+	s64 delay_ns = now_ns - tc6->tx_release_ns;
+	s64 late_ns = now_ns - tc6->tx_launch_ns;
+
+	stats->txtime_frames++;
+	if (late_ns > (s64)tc6->txtime_window_ns)
+		stats->txtime_late++;
+	else if (late_ns < -(s64)tc6->txtime_window_ns)
+		stats->txtime_early++;
+	if (late_ns > 0 && late_ns > stats->txtime_max_late_ns)
+		stats->txtime_max_late_ns = late_ns;
+
+	/* Moving average over the last 8 frames or so */
+	if (delay_ns >= 0 && delay_ns < OA_TC6_TXTIME_MAX_DELAY_NS)
+		tc6->txtime_delay_ns += (delay_ns - (s64)tc6->txtime_delay_ns) / 8;
+
+	tc6->tx_launch_ns = 0;
+	tc6->tx_release_ns = 0;
+}
+
+/* Returns the TSC value for the frame, 0 if no tx timestamp is needed */
+static u8 oa_tc6_tx_ts_request(struct oa_tc6 *tc6, struct sk_buff *skb)
+{
+	struct sk_buff *stale;
+
+	if (likely(!(skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP)) ||
+	    !tc6->hwts_tx_en)
+		return 0;
+
+	/* Only one capture register is used. A capture which never showed
+	 * up doesn't block the following ones for long.
+	 */
+	if (READ_ONCE(tc6->tx_ts_skb)) {
+		if (time_before(jiffies, tc6->tx_ts_start + HZ))
+			return 0;
+		stale = xchg(&tc6->tx_ts_skb, NULL);
+		dev_kfree_skb_any(stale);
 	}
-	return FTR_ERR;
+
+	skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
+	tc6->tx_ts_start = jiffies;
+	WRITE_ONCE(tc6->tx_ts_skb, skb_get(skb));
+
+	return OA_TC6_TSC_A;
+}
+
+/* Called by the tc6 task at a frame boundary */
+static void oa_tc6_tx_next(struct oa_tc6 *tc6)
+{
+	struct sk_buff *skb;
+	u8 tsc;
+
+	/* Cleared first, a frame queued meanwhile sets it again */
+	tc6->tx_flag = false;
+	skb = oa_tc6_tx_dequeue(tc6);
+	if (!skb)
+		return;
+
+	tc6->tx_skb = skb;
+	tsc = oa_tc6_tx_ts_request(tc6, skb);
+	/* Prepare tx chunks using the tx ethernet frame */
+	oa_tc6_prepare_tx_chunks(tc6, tc6->eth_tx_buf, skb->data, skb->len,
+				 tsc);
+	tc6->tx_flag = true;
+}
+
+static void oa_tc6_tx_done(struct oa_tc6 *tc6)
+{
+	struct sk_buff *skb = tc6->tx_skb;
+	u16 q = skb_get_queue_mapping(skb);
+	struct oa_tc6_txq_stats *stats;
+
+	netdev_tx_completed_queue(netdev_get_tx_queue(tc6->netdev, q), 1,
+				  skb->len);
+	stats = &tc6->tx_q_stats[q];
+	stats->packets++;
+	stats->bytes += skb->len;
+	tc6->netdev->stats.tx_packets++;
+	tc6->netdev->stats.tx_bytes += skb->len;
+	dev_kfree_skb(skb);
+	tc6->tx_skb = NULL;
 }
 
 static int oa_tc6_handler(void *data)
 {
 	struct oa_tc6 *tc6 = data;
 	bool txc_wait = false;
+	u64 rx_data_chunks;
+	u8 rx_needed;
+	u8 rx_chunks;
+	u8 tx_chunks;
+	u8 rx_budget;
+	u8 tx_budget;
+	u16 tx_len;
+	u8 chunks;
 	u16 tx_pos = 0;
 	u32 regval;
 	u16 len;
 	int ret;
 
 	while (likely(!kthread_should_stop())) {
+		/* Keep the bus for the next round while there is work left
+		 * and the turn isn't used up, otherwise let the other devices
+		 * on the SPI controller have it.
+		 */
+		if (tc6->tx_flag || tc6->int_flag || tc6->rca)
+			oa_tc6_sched_yield(tc6);
+		else
+			oa_tc6_sched_release(tc6, true);
 		wait_event_interruptible(tc6->tc6_wq, tc6->tx_flag ||
 					 tc6->int_flag || tc6->rca ||
+					 tc6->txc_poll ||
+					 READ_ONCE(tc6->recovery_req) ||
+					 READ_ONCE(tc6->bus_stats_reset) ||
+					 kthread_should_park() ||
 					 kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+		/* The data path counters are only updated here. Control
+		 * transactions from other contexts aren't held off, they may
+		 * still be counted across the reset.
+		 */
+		if (unlikely(READ_ONCE(tc6->bus_stats_reset))) {
+			memset(&tc6->bus_stats, 0, sizeof(tc6->bus_stats));
+			tc6->bus_stats_start_ns = ktime_get_ns();
+			WRITE_ONCE(tc6->bus_stats_reset, false);
+		}
+		if (kthread_should_park()) {
+			oa_tc6_sched_release(tc6, true);
+			kthread_parkme();
+			/* Reconfigured by oa_tc6_resume(), the tx frame
+			 * in flight is resent from its start.
+			 */
+			txc_wait = false;
+			tc6->txc_stall_start_ns = 0;
+			tx_pos = 0;
+			tc6->txc_needed = tc6->total_txc_needed;
+			tc6->tx_flag = tc6->tx_skb || oa_tc6_tx_pending(tc6);
+			continue;
+		}
+		oa_tc6_sched_acquire(tc6);
+		/* The MAC-PHY was reset, the tx frame in flight is resent
+		 * from its start.
+		 */
+		if (unlikely(READ_ONCE(tc6->recovery_req)) &&
+		    oa_tc6_recovery_run_request(tc6) && tc6->tx_skb) {
+			tx_pos = 0;
+			tc6->txc_needed = tc6->total_txc_needed;
+			tc6->tx_flag = true;
+		}
 		if (tc6->int_flag && !tc6->reset) {
 			tc6->int_flag = false;
 			tc6->reset = true;
@@ -443,160 +698,180 @@ static int oa_tc6_handler(void *data)
 			}
 		}
 
+		/* Credits are likely back, fetch them instead of waiting for
+		 * the interrupt.
+		 */
+		if (unlikely(tc6->txc_poll) && oa_tc6_txc_poll(tc6) &&
+		    txc_wait)
+			tc6->tx_flag = true;
+
+		/* Take the next frame before sizing the transfer, its chunks
+		 * go out in the same transfer as the pending rx chunks.
+		 */
+		if (tc6->tx_flag && !tc6->tx_skb)
+			oa_tc6_tx_next(tc6);
+
+		rx_needed = 0;
 		if (tc6->int_flag || tc6->rca) {
 			/* If rca is updated from the previous footer then
 			 * prepare the empty chunks equal to rca and perform
 			 * SPI transfer to receive the ethernet frame.
 			 */
 			if (tc6->rca) {
-				len = oa_tc6_prepare_empty_chunk(tc6,
-								 tc6->spi_tx_buf,
-								 tc6->rca);
+				rx_needed = tc6->rca;
 			} else {
 				/* If there is an interrupt then perform a SPI
 				 * transfer with a empty chunk to get the
 				 * details.
 				 */
 				tc6->int_flag = false;
-				len = oa_tc6_prepare_empty_chunk(tc6,
-								 tc6->spi_tx_buf,
-								 1);
-			}
-			/* Perform SPI transfer */
-			ret = oa_tc6_spi_transfer(tc6->spi, tc6->spi_tx_buf,
-						  tc6->spi_rx_buf, len);
-			if (ret) {
-				netdev_err(tc6->netdev, "SPI transfer failed\n");
-				continue;
+				tc6->rx_burst_chunks = 0;
+				rx_needed = 1;
 			}
-			/* Process the received chunks to get the ethernet frame
-			 * or interrupt details.
-			 */
-			if (oa_tc6_process_rx_chunks(tc6, tc6->spi_rx_buf, len))
-				continue;
+		}
+
+		/* Neither direction takes more than its budget of chunks in a
+		 * transfer, what is left goes in the next one.
+		 */
+		rx_budget = READ_ONCE(tc6->rx_budget);
+		if (rx_needed > rx_budget) {
+			rx_needed = rx_budget;
+			tc6->bus_stats.rx_budget_exhausted++;
 		}
 
 		/* If there is a tx ethernet frame available */
-		if (tc6->tx_flag || txc_wait) {
+		tx_chunks = 0;
+		if (tc6->tx_skb && (tc6->tx_flag || txc_wait)) {
 			tc6->tx_flag = false;
 			txc_wait = false;
-			len = 0;
 			if (!tc6->txc) {
 				/* If there is no txc available to transport the
 				 * tx ethernet frames then wait for the MAC-PHY
-				 * interrupt to get the txc availability.
+				 * interrupt to get the txc availability, or
+				 * poll for it when it should be back.
 				 */
 				txc_wait = true;
-				continue;
-			} else if (tc6->txc >= tc6->txc_needed) {
-				len = tc6->txc_needed * (tc6->cps + TC6_HDR_SIZE);
+				oa_tc6_txc_stall(tc6);
 			} else {
-				len = tc6->txc * (tc6->cps + TC6_HDR_SIZE);
+				tx_chunks = min(tc6->txc, tc6->txc_needed);
 			}
-			memcpy(&tc6->spi_tx_buf[0], &tc6->eth_tx_buf[tx_pos],
-			       len);
-			ret = oa_tc6_spi_transfer(tc6->spi, tc6->spi_tx_buf,
-						  tc6->spi_rx_buf, len);
-			if (ret) {
-				netdev_err(tc6->netdev, "SPI transfer failed\n");
-				continue;
+			tx_budget = READ_ONCE(tc6->tx_budget);
+			if (tx_chunks > tx_budget) {
+				tx_chunks = tx_budget;
+				tc6->bus_stats.tx_budget_exhausted++;
 			}
-			/* Process the received chunks to get the ethernet frame
-			 * or status.
+		}
+
+		if (!rx_needed && !tx_chunks)
+			continue;
+
+		/* The SPI is full duplex, every transfer carries the tx
+		 * chunks the credits allow and receives the rx chunks, the
+		 * shorter direction is filled up with empty chunks.
+		 */
+		rx_chunks = 0;
+		if (rx_needed)
+			rx_chunks = min(oa_tc6_rx_read_ahead(tc6, rx_needed),
+					rx_budget);
+		chunks = max(rx_chunks, tx_chunks);
+		tx_len = tx_chunks * (tc6->cps + TC6_HDR_SIZE);
+		memcpy(&tc6->spi_tx_buf[0], &tc6->eth_tx_buf[tx_pos], tx_len);
+		len = oa_tc6_prepare_empty_chunk(tc6, &tc6->spi_tx_buf[tx_len],
+						 chunks - tx_chunks);
+		len += tx_len;
+		/* Perform SPI transfer */
+		if (tx_chunks)
+			oa_tc6_txc_unstall(tc6);
+		ret = oa_tc6_spi_data_transfer(tc6, len);
+		if (ret) {
+			netdev_err(tc6->netdev, "SPI transfer failed\n");
+			if (tx_chunks)
+				tc6->tx_flag = true;
+			continue;
+		}
+		/* Process the received chunks to get the ethernet frame or
+		 * interrupt details.
+		 */
+		rx_data_chunks = tc6->bus_stats.rx_data_chunks;
+		ret = oa_tc6_process_rx_chunks(tc6, tc6->spi_rx_buf, len);
+		rx_data_chunks = tc6->bus_stats.rx_data_chunks - rx_data_chunks;
+		oa_tc6_account_data_xfer(tc6, chunks, tx_pos, tx_chunks,
+					 rx_data_chunks);
+		if (rx_needed && tx_chunks)
+			tc6->bus_stats.duplex_xfers++;
+		if (ret) {
+			/* In case of error while processing rx chunks discard
+			 * the incomplete tx ethernet frame and resend it.
 			 */
-			if (oa_tc6_process_rx_chunks(tc6, tc6->spi_rx_buf,
-						     len)) {
-				/* In case of error while processing rx chunks
-				 * discard the incomplete tx ethernet frame and
-				 * resend it.
-				 */
+			if ((oa_tc6_recovery_error(tc6) || tx_chunks) &&
+			    tc6->tx_skb) {
 				tx_pos = 0;
 				tc6->txc_needed = tc6->total_txc_needed;
-			} else {
-				tx_pos += len;
-				tc6->txc_needed = tc6->txc_needed -
-						  (len / (tc6->cps + TC6_HDR_SIZE));
-				/* If the complete ethernet frame is transmitted
-				 * then return the skb and update the details to
-				 * n/w layer.
-				 */
-				if (!tc6->txc_needed) {
-					tc6->netdev->stats.tx_packets++;
-					tc6->netdev->stats.tx_bytes += tc6->tx_skb->len;
-					dev_kfree_skb(tc6->tx_skb);
-					tx_pos = 0;
-					tc6->tx_skb = NULL;
-					if (netif_queue_stopped(tc6->netdev))
-						netif_wake_queue(tc6->netdev);
-				} else if (tc6->txc) {
-					/* If txc is available again and updated
-					 * from the previous footer then perform
-					 * tx again.
-					 */
-					tc6->tx_flag = true;
-				} else {
-					/* If there is no txc then wait for the
-					 * interrupt to indicate txc
-					 * availability.
-					 */
-					txc_wait = true;
-				}
+				tc6->tx_flag = true;
 			}
+			continue;
 		}
-	}
-	return 0;
-}
-
-static void oa_tc6_prepare_tx_chunks(struct oa_tc6 *tc6, u8 *buf,
-				     struct sk_buff *skb)
-{
-	bool frame_started = false;
-	u16 copied_bytes = 0;
-	u16 copy_len;
-	u32 hdr;
-
-	/* Calculate the number tx credit counts needed to transport the tx
-	 * ethernet frame.
-	 */
-	tc6->txc_needed = (skb->len / tc6->cps) + ((skb->len % tc6->cps) ? 1 : 0);
-	tc6->total_txc_needed = tc6->txc_needed;
-
-	for (u8 i = 0; i < tc6->txc_needed; i++) {
-		/* Prepare the header for each chunks to be transmitted */
-		hdr = FIELD_PREP(DATA_HDR_DNC, 1) |
-		      FIELD_PREP(DATA_HDR_DV, 1);
-		if (!frame_started) {
-			hdr |= FIELD_PREP(DATA_HDR_SV, 1) |
-			       FIELD_PREP(DATA_HDR_SWO, 0);
-			frame_started = true;
+		oa_tc6_recovery_ok(tc6);
+		if (rx_needed)
+			oa_tc6_rx_read_ahead_done(tc6, rx_needed, rx_chunks,
+						  rx_data_chunks);
+		if (!tx_chunks) {
+			/* The footers brought credits for the waiting frame */
+			if (txc_wait && tc6->txc)
+				tc6->tx_flag = true;
+			continue;
 		}
-		if ((tc6->cps + copied_bytes) >= skb->len) {
-			copy_len = skb->len - copied_bytes;
-			hdr |= FIELD_PREP(DATA_HDR_EBO, copy_len - 1) |
-			       FIELD_PREP(DATA_HDR_EV, 1);
+
+		tx_pos += tx_len;
+		tc6->txc_needed -= tx_chunks;
+		/* If the complete ethernet frame is transmitted then return
+		 * the skb and update the details to n/w layer.
+		 */
+		if (!tc6->txc_needed) {
+			if (tc6->tx_launch_ns)
+				oa_tc6_txtime_done(tc6);
+			oa_tc6_tx_done(tc6);
+			tx_pos = 0;
+			tc6->tx_flag = oa_tc6_tx_pending(tc6);
+		} else if (tc6->txc) {
+			/* If txc is available again and updated from the
+			 * previous footer then perform tx again.
+			 */
+			tc6->tx_flag = true;
 		} else {
-			copy_len = tc6->cps;
+			/* If there is no txc then wait for the interrupt to
+			 * indicate txc availability.
+			 */
+			txc_wait = true;
+			oa_tc6_txc_stall(tc6);
 		}
-		copied_bytes += copy_len;
-		hdr |= FIELD_PREP(DATA_HDR_P, oa_tc6_get_parity(hdr));
-		hdr = cpu_to_be32(hdr);
-		*(u32 *)&buf[i * (tc6->cps + TC6_HDR_SIZE)] = hdr;
-		/* Copy the ethernet frame in the chunk payload section */
-		memcpy(&buf[TC6_HDR_SIZE + (i * (tc6->cps + TC6_HDR_SIZE))],
-		       &skb->data[copied_bytes - copy_len], copy_len);
 	}
+	oa_tc6_sched_release(tc6, true);
+	return 0;
 }
 
 netdev_tx_t oa_tc6_send_eth_pkt(struct oa_tc6 *tc6, struct sk_buff *skb)
 {
-	if (tc6->tx_skb) {
-		netif_stop_queue(tc6->netdev);
+	u16 q = skb_get_queue_mapping(skb);
+	struct sk_buff_head *txq = &tc6->tx_q[q];
+
+	if (skb_queue_len(txq) >= OA_TC6_TX_QUEUE_LEN) {
+		netif_stop_subqueue(tc6->netdev, q);
 		return NETDEV_TX_BUSY;
 	}
 
-	tc6->tx_skb = skb;
-	/* Prepare tx chunks using the tx ethernet frame */
-	oa_tc6_prepare_tx_chunks(tc6, tc6->eth_tx_buf, skb);
+	skb_tx_timestamp(skb);
+	/* Byte queue limits, accounted before the tc6 task can see it */
+	netdev_tx_sent_queue(netdev_get_tx_queue(tc6->netdev, q), skb->len);
+	skb_queue_tail(txq, skb);
+	if (skb_queue_len(txq) >= OA_TC6_TX_QUEUE_LEN) {
+		netif_stop_subqueue(tc6->netdev, q);
+		tc6->tx_q_stats[q].stopped++;
+		/* Unless the tc6 task made room meanwhile */
+		smp_mb();
+		if (skb_queue_len(txq) < OA_TC6_TX_QUEUE_LEN)
+			netif_wake_subqueue(tc6->netdev, q);
+	}
 
 	/* Wake tc6 task to perform tx transfer */
 	tc6->tx_flag = true;
@@ -617,24 +892,231 @@ static irqreturn_t macphy_irq(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+/* The PHY interrupt is signalled in STS0 like the MAC-PHY's own events. It
+ * is handled in the context of the tc6 task, which makes the PHY driver's
+ * register accesses go out in between the data transfers instead of
+ * competing with them.
+ */
+static void oa_tc6_phy_irq_mask(struct irq_data *d)
+{
+	struct oa_tc6 *tc6 = irq_data_get_irq_chip_data(d);
+
+	tc6->phy_irq_masked = true;
+}
+
+static void oa_tc6_phy_irq_unmask(struct irq_data *d)
+{
+	struct oa_tc6 *tc6 = irq_data_get_irq_chip_data(d);
+
+	tc6->phy_irq_masked = false;
+}
+
+static void oa_tc6_phy_irq_bus_lock(struct irq_data *d)
+{
+}
+
+/* IMASK0 can only be written from a context which can sleep */
+static void oa_tc6_phy_irq_bus_sync_unlock(struct irq_data *d)
+{
+	struct oa_tc6 *tc6 = irq_data_get_irq_chip_data(d);
+	u32 regval;
+
+	if (tc6->phy_irq_masked)
+		regval = tc6->imask0 | PHYINT;
+	else
+		regval = tc6->imask0 & PHYINTM;
+	if (regval == tc6->imask0)
+		return;
+
+	if (oa_tc6_write_register(tc6, OA_TC6_IMASK0, &regval, 1)) {
+		netdev_err(tc6->netdev, "IMASK0 register write failed.\n");
+		return;
+	}
+	tc6->imask0 = regval;
+}
+
+static struct irq_chip oa_tc6_phy_irq_chip = {
+	.name = "oa-tc6-phy",
+	.irq_mask = oa_tc6_phy_irq_mask,
+	.irq_unmask = oa_tc6_phy_irq_unmask,
+	.irq_bus_lock = oa_tc6_phy_irq_bus_lock,
+	.irq_bus_sync_unlock = oa_tc6_phy_irq_bus_sync_unlock,
+};
+
+static int oa_tc6_phy_irq_map(struct irq_domain *d, unsigned int virq,
+			      irq_hw_number_t hw)
+{
+	irq_set_chip_data(virq, d->host_data);
+	irq_set_chip_and_handler(virq, &oa_tc6_phy_irq_chip, handle_simple_irq);
+	irq_set_nested_thread(virq, true);
+	irq_set_noprobe(virq);
+
+	return 0;
+}
+
+static const struct irq_domain_ops oa_tc6_phy_irq_domain_ops = {
+	.map = oa_tc6_phy_irq_map,
+	.xlate = irq_domain_xlate_onecell,
+};
+
+static int oa_tc6_phy_irq_init(struct oa_tc6 *tc6)
+{
+	/* Without the MAC-PHY interrupt the PHY has to be polled */
+	if (tc6->spi->irq <= 0)
+		return 0;
+
+	tc6->phy_irq_masked = true;
+	tc6->phy_irq_domain = irq_domain_add_linear(NULL, 1,
+						    &oa_tc6_phy_irq_domain_ops,
+						    tc6);
+	if (!tc6->phy_irq_domain)
+		return -ENOMEM;
+
+	tc6->phy_irq = irq_create_mapping(tc6->phy_irq_domain, 0);
+	if (!tc6->phy_irq) {
+		irq_domain_remove(tc6->phy_irq_domain);
+		tc6->phy_irq_domain = NULL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void oa_tc6_phy_irq_deinit(struct oa_tc6 *tc6)
+{
+	if (!tc6->phy_irq_domain)
+		return;
+
+	irq_dispose_mapping(tc6->phy_irq);
+	irq_domain_remove(tc6->phy_irq_domain);
+}
+
+/**
+ * oa_tc6_get_phy_irq - interrupt of the internal PHY
+ * @tc6: oa_tc6 struct.
+ *
+ * For mii_bus.irq[] of the PHY, so that phylib uses the PHY driver's
+ * interrupt support instead of polling the PHY over SPI.
+ *
+ * Return: the interrupt number or PHY_POLL if the MAC-PHY has no interrupt.
+ */
+int oa_tc6_get_phy_irq(struct oa_tc6 *tc6)
+{
+	return tc6->phy_irq > 0 ? tc6->phy_irq : PHY_POLL;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_phy_irq);
+
+/* Write the software reset with both protected and unprotected control
+ * commands because the driver doesn't know the current status of the
+ * MAC-PHY. Both go out in one SPI message, the echo of a reset write isn't
+ * checked anyway.
+ */
+int oa_tc6_reset_write(struct oa_tc6 *tc6)
+{
+	u16 prot_size = oa_tc6_ctrl_size(1, true);
+	u16 size = prot_size + oa_tc6_ctrl_size(1, false);
+	struct spi_transfer xfer[2] = { };
+	struct spi_message msg;
+	u32 regval = SW_RESET;
+	u8 *tx_buf;
+	u8 *rx_buf;
+	int ret;
+
+	tx_buf = kzalloc(size, GFP_KERNEL);
+	if (!tx_buf)
+		return -ENOMEM;
+
+	rx_buf = kzalloc(size, GFP_KERNEL);
+	if (!rx_buf) {
+		kfree(tx_buf);
+		return -ENOMEM;
+	}
+
+	oa_tc6_prepare_ctrl_buf(tc6, OA_TC6_RESET, &regval, 1, true, tx_buf,
+				true);
+	oa_tc6_prepare_ctrl_buf(tc6, OA_TC6_RESET, &regval, 1, true,
+				&tx_buf[prot_size], false);
+
+	/* Each control command is framed by the chip select */
+	xfer[0].tx_buf = tx_buf;
+	xfer[0].rx_buf = rx_buf;
+	xfer[0].len = prot_size;
+	xfer[0].cs_change = 1;
+	xfer[1].tx_buf = &tx_buf[prot_size];
+	xfer[1].rx_buf = &rx_buf[prot_size];
+	xfer[1].len = size - prot_size;
+	spi_message_init(&msg);
+	spi_message_add_tail(&xfer[0], &msg);
+	spi_message_add_tail(&xfer[1], &msg);
+
+	/* Both commands go into one trace record */
+	ret = oa_tc6_spi_sync(tc6, &msg, tx_buf, rx_buf, size);
+	if (!ret) {
+		tc6->bus_stats.ctrl_xfers += 2;
+		tc6->bus_stats.ctrl_bytes += size;
+	}
+
+	kfree(rx_buf);
+	kfree(tx_buf);
+	return ret;
+}
+
+/**
+ * oa_tc6_suspend - stop the data transfer for system suspend
+ * @tc6: oa_tc6 struct.
+ *
+ * The tc6 task is parked and the MAC-PHY interrupt disabled. The MAC layer
+ * detaches the netdev and disables the MAC before.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_suspend(struct oa_tc6 *tc6)
+{
+	if (tc6->spi->irq > 0)
+		disable_irq(tc6->spi->irq);
+	kthread_park(tc6->tc6_task);
+	hrtimer_cancel(&tc6->txtime_timer);
+	hrtimer_cancel(&tc6->txc_timer);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_suspend);
+
+/**
+ * oa_tc6_resume - restart the data transfer after system suspend
+ * @tc6: oa_tc6 struct.
+ *
+ * The MAC-PHY may have been powered off. It is reset and its configuration
+ * replayed from the cached values like in an error recovery, without going
+ * through the probe again.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_resume(struct oa_tc6 *tc6)
+{
+	int ret;
+
+	ret = oa_tc6_reconfigure(tc6);
+	if (ret)
+		netdev_err(tc6->netdev, "MAC-PHY reconfiguration failed (%d)\n",
+			   ret);
+
+	kthread_unpark(tc6->tc6_task);
+	if (tc6->spi->irq > 0)
+		enable_irq(tc6->spi->irq);
+	wake_up_interruptible(&tc6->tc6_wq);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_resume);
+
 static int oa_tc6_sw_reset(struct oa_tc6 *tc6)
 {
 	long timeleft;
-	u32 regval;
 	int ret;
 
-	/* Perform software reset with both protected and unprotected control
-	 * commands because the driver doesn't know the current status of the
-	 * MAC-PHY.
-	 */
-	regval = SW_RESET;
 	reinit_completion(&tc6->rst_complete);
-	ret = oa_tc6_perform_ctrl(tc6, OA_TC6_RESET, &regval, 1, true, true);
-	if (ret) {
-		dev_err(&tc6->spi->dev, "RESET register write failed\n");
-		return ret;
-	}
-	ret = oa_tc6_perform_ctrl(tc6, OA_TC6_RESET, &regval, 1, true, false);
+	ret = oa_tc6_reset_write(tc6);
 	if (ret) {
 		dev_err(&tc6->spi->dev, "RESET register write failed\n");
 		return ret;
@@ -665,26 +1147,27 @@ EXPORT_SYMBOL_GPL(oa_tc6_read_register);
 int oa_tc6_configure(struct oa_tc6 *tc6, u8 cps, bool ctrl_prot, bool tx_cut_thr,
 		     bool rx_cut_thr)
 {
+	u32 regs[2];
 	u32 regval;
 	int ret;
 
-	/* Read BUFSTS register to get the current txc and rca. */
-	ret = oa_tc6_read_register(tc6, OA_TC6_BUFSTS, &regval, 1);
+	/* Read BUFSTS register to get the current txc and rca, and the IMASK0
+	 * register following it in the same control transaction.
+	 */
+	ret = oa_tc6_read_register(tc6, OA_TC6_BUFSTS, regs, 2);
 	if (ret)
 		return ret;
 
-	tc6->txc = FIELD_GET(TXC, regval);
-	tc6->rca = FIELD_GET(RCA, regval);
-
-	/* Read and configure the IMASK0 register for unmasking the interrupts */
-	ret = oa_tc6_read_register(tc6, OA_TC6_IMASK0, &regval, 1);
-	if (ret)
-		return ret;
+	tc6->txc = FIELD_GET(TXC, regs[0]);
+	tc6->rca = FIELD_GET(RCA, regs[0]);
 
-	regval &= TXPEM & TXBOEM & TXBUEM & RXBOEM & LOFEM & HDREM;
+	/* Configure the IMASK0 register for unmasking the interrupts */
+	regval = regs[1];
+	regval &= TXPEM & TXBOEM & TXBUEM & RXBOEM & LOFEM & HDREM & TTSCAAM;
 	ret = oa_tc6_write_register(tc6, OA_TC6_IMASK0, &regval, 1);
 	if (ret)
 		return ret;
+	tc6->imask0 = regval;
 
 	/* Configure the CONFIG0 register with the required configurations */
 	regval = SYNC;
@@ -700,7 +1183,9 @@ int oa_tc6_configure(struct oa_tc6 *tc6, u8 cps, bool ctrl_prot, bool tx_cut_thr
 	if (ret)
 		return ret;
 
+	tc6->config0 = regval;
 	tc6->cps = cps;
+	oa_tc6_select_chunk_ops(tc6);
 	tc6->ctrl_prot = ctrl_prot;
 	tc6->tx_cut_thr = tx_cut_thr;
 	tc6->rx_cut_thr = rx_cut_thr;
@@ -709,6 +1194,471 @@ int oa_tc6_configure(struct oa_tc6 *tc6, u8 cps, bool ctrl_prot, bool tx_cut_thr
 }
 EXPORT_SYMBOL_GPL(oa_tc6_configure);
 
+/* The MAC-PHY timestamps either all frames or none */
+int oa_tc6_hwtstamp_set(struct oa_tc6 *tc6, struct ifreq *ifr)
+{
+	struct hwtstamp_config config;
+	u32 regval, old;
+	int ret;
+
+	if (copy_from_user(&config, ifr->ifr_data, sizeof(config)))
+		return -EFAULT;
+
+	if (config.flags)
+		return -EINVAL;
+
+	if (config.tx_type != HWTSTAMP_TX_OFF &&
+	    config.tx_type != HWTSTAMP_TX_ON)
+		return -ERANGE;
+
+	if (config.rx_filter != HWTSTAMP_FILTER_NONE)
+		config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+	old = READ_ONCE(tc6->config0);
+	regval = old & ~(FTSE | FTSS);
+	if (config.tx_type == HWTSTAMP_TX_ON ||
+	    config.rx_filter == HWTSTAMP_FILTER_ALL)
+		regval |= FTSE | FTSS;
+	if (regval != old) {
+		/* Cached before the write, so that a reset replay by the tc6
+		 * task or a resume running meanwhile restores the new value.
+		 */
+		WRITE_ONCE(tc6->config0, regval);
+		ret = oa_tc6_write_register(tc6, OA_TC6_CONFIG0, &regval, 1);
+		if (ret) {
+			WRITE_ONCE(tc6->config0, old);
+			return ret;
+		}
+	}
+	tc6->hwts_tx_en = config.tx_type == HWTSTAMP_TX_ON;
+	tc6->hwts_rx_en = config.rx_filter == HWTSTAMP_FILTER_ALL;
+
+	return copy_to_user(ifr->ifr_data, &config, sizeof(config)) ?
+	       -EFAULT : 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_hwtstamp_set);
+
+int oa_tc6_hwtstamp_get(struct oa_tc6 *tc6, struct ifreq *ifr)
+{
+	struct hwtstamp_config config = {};
+
+	config.tx_type = tc6->hwts_tx_en ? HWTSTAMP_TX_ON : HWTSTAMP_TX_OFF;
+	config.rx_filter = tc6->hwts_rx_en ? HWTSTAMP_FILTER_ALL :
+					     HWTSTAMP_FILTER_NONE;
+
+	return copy_to_user(ifr->ifr_data, &config, sizeof(config)) ?
+	       -EFAULT : 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_hwtstamp_get);
+
+/**
+ * oa_tc6_set_rx_csum - checksum received frames during the reassembly
+ * @tc6: oa_tc6 struct.
+ * @enable: pass frames up with CHECKSUM_COMPLETE, for NETIF_F_RXCSUM.
+ *
+ * Takes effect from the next frame on.
+ */
+void oa_tc6_set_rx_csum(struct oa_tc6 *tc6, bool enable)
+{
+	WRITE_ONCE(tc6->rx_csum_en, enable);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_rx_csum);
+
+/**
+ * oa_tc6_set_rx_hash - hash the flow of received frames for RPS
+ * @tc6: oa_tc6 struct.
+ * @enable: pass frames up with an L3 or L4 hash, for NETIF_F_RXHASH.
+ *
+ * Takes effect from the next frame on.
+ */
+void oa_tc6_set_rx_hash(struct oa_tc6 *tc6, bool enable)
+{
+	WRITE_ONCE(tc6->rx_hash_en, enable);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_rx_hash);
+
+/**
+ * oa_tc6_setup_etf - offload of the ETF qdisc
+ * @tc6: oa_tc6 struct.
+ * @qopt: ETF offload parameters.
+ *
+ * With the offload enabled, frames are held in the driver until their
+ * SO_TXTIME launch time, in CLOCK_TAI.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int oa_tc6_setup_etf(struct oa_tc6 *tc6, struct tc_etf_qopt_offload *qopt)
+{
+	if (qopt->queue < 0 || qopt->queue >= tc6->tx_queues)
+		return -EINVAL;
+
+	if (qopt->enable)
+		WRITE_ONCE(tc6->txtime_queues,
+			   tc6->txtime_queues | BIT(qopt->queue));
+	else
+		WRITE_ONCE(tc6->txtime_queues,
+			   tc6->txtime_queues & ~BIT(qopt->queue));
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_setup_etf);
+
+/**
+ * oa_tc6_setup_mqprio - offload of the mqprio qdisc
+ * @tc6: oa_tc6 struct.
+ * @mqprio: mqprio offload parameters.
+ *
+ * The tx queues are served in strict priority, the highest queue first, so
+ * traffic classes mapped to higher queues get ahead at each frame boundary.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int oa_tc6_setup_mqprio(struct oa_tc6 *tc6,
+			struct tc_mqprio_qopt_offload *mqprio)
+{
+	struct tc_mqprio_qopt *qopt = &mqprio->qopt;
+	struct net_device *netdev = tc6->netdev;
+	int ret;
+
+	if (!qopt->num_tc) {
+		netdev_reset_tc(netdev);
+		return 0;
+	}
+
+	/* No rate limiting in the MAC-PHY */
+	if (mqprio->mode != TC_MQPRIO_MODE_DCB ||
+	    mqprio->shaper != TC_MQPRIO_SHAPER_DCB)
+		return -EOPNOTSUPP;
+
+	ret = netdev_set_num_tc(netdev, qopt->num_tc);
+	if (ret)
+		return ret;
+
+	for (u8 tc = 0; tc < qopt->num_tc; tc++)
+		netdev_set_tc_queue(netdev, tc, qopt->count[tc],
+				    qopt->offset[tc]);
+	for (u8 prio = 0; prio <= TC_BITMASK; prio++)
+		netdev_set_prio_tc_map(netdev, prio, qopt->prio_tc_map[prio]);
+	qopt->hw = TC_MQPRIO_HW_OFFLOAD_TCS;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_setup_mqprio);
+
+/**
+ * oa_tc6_select_queue - tx queue of a frame, for ndo_select_queue
+ * @tc6: oa_tc6 struct.
+ * @skb: frame to send.
+ * @sb_dev: subordinate device, if any.
+ *
+ * Without mqprio the eight socket priorities are spread evenly over the
+ * queues, TC_PRIO_CONTROL going to the highest one.
+ *
+ * Return: the tx queue index.
+ */
+u16 oa_tc6_select_queue(struct oa_tc6 *tc6, struct sk_buff *skb,
+			struct net_device *sb_dev)
+{
+	u32 prio = skb->priority;
+
+	if (netdev_get_num_tc(tc6->netdev))
+		return netdev_pick_tx(tc6->netdev, skb, sb_dev);
+
+	if (prio > TC_PRIO_CONTROL)
+		prio = TC_PRIO_BESTEFFORT;
+
+	return prio * tc6->tx_queues / (TC_PRIO_CONTROL + 1);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_select_queue);
+
+/* Share of the SPI bus against the other devices on the same controller */
+void oa_tc6_set_sched_weight(struct oa_tc6 *tc6, u32 weight)
+{
+	tc6->sched_weight = clamp_t(u32, weight, 1, OA_TC6_SCHED_MAX_WEIGHT);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_sched_weight);
+
+struct oa_tc6_stat_desc {
+	char name[ETH_GSTRING_LEN];
+	u16 offset;
+};
+
+#define OA_TC6_BUS_STAT(_name, _member) \
+	{ _name, offsetof(struct oa_tc6_bus_stats, _member) }
+
+static const struct oa_tc6_stat_desc oa_tc6_bus_stats_desc[] = {
+	OA_TC6_BUS_STAT("spi_bytes", spi_bytes),
+	OA_TC6_BUS_STAT("spi_busy_ns", spi_busy_ns),
+	OA_TC6_BUS_STAT("spi_data_xfers", data_xfers),
+	OA_TC6_BUS_STAT("spi_duplex_xfers", duplex_xfers),
+	OA_TC6_BUS_STAT("spi_ctrl_xfers", ctrl_xfers),
+	OA_TC6_BUS_STAT("spi_tx_payload_bytes", tx_payload_bytes),
+	OA_TC6_BUS_STAT("spi_tx_pad_bytes", tx_pad_bytes),
+	OA_TC6_BUS_STAT("spi_rx_payload_bytes", rx_payload_bytes),
+	OA_TC6_BUS_STAT("spi_rx_data_chunks", rx_data_chunks),
+	OA_TC6_BUS_STAT("spi_empty_bytes", empty_bytes),
+	OA_TC6_BUS_STAT("spi_hdr_ftr_bytes", hdr_ftr_bytes),
+	OA_TC6_BUS_STAT("spi_ctrl_bytes", ctrl_bytes),
+	OA_TC6_BUS_STAT("spi_ctrl_prot_bytes", ctrl_prot_bytes),
+	OA_TC6_BUS_STAT("spi_sched_grants", sched_grants),
+	OA_TC6_BUS_STAT("spi_sched_wait_ns", sched_wait_ns),
+	OA_TC6_BUS_STAT("spi_sched_max_wait_ns", sched_max_wait_ns),
+	OA_TC6_BUS_STAT("spi_rx_ahead_xfers", rx_ahead_xfers),
+	OA_TC6_BUS_STAT("spi_rx_ahead_saved", rx_ahead_saved),
+	OA_TC6_BUS_STAT("spi_rx_ahead_wasted", rx_ahead_wasted),
+	OA_TC6_BUS_STAT("spi_rx_budget_exhausted", rx_budget_exhausted),
+	OA_TC6_BUS_STAT("spi_tx_budget_exhausted", tx_budget_exhausted),
+};
+
+#define OA_TC6_TX_STAT(_name, _member) \
+	{ _name, offsetof(struct oa_tc6_tx_stats, _member) }
+
+static const struct oa_tc6_stat_desc oa_tc6_tx_stats_desc[] = {
+	OA_TC6_TX_STAT("txtime_frames", txtime_frames),
+	OA_TC6_TX_STAT("txtime_late", txtime_late),
+	OA_TC6_TX_STAT("txtime_early", txtime_early),
+	OA_TC6_TX_STAT("txtime_max_late_ns", txtime_max_late_ns),
+	OA_TC6_TX_STAT("txc_stalls", txc_stalls),
+	OA_TC6_TX_STAT("txc_stall_ns", txc_stall_ns),
+	OA_TC6_TX_STAT("txc_polls", txc_polls),
+	OA_TC6_TX_STAT("txc_polls_empty", txc_polls_empty),
+};
+
+#define OA_TC6_TXQ_STAT(_name, _member) \
+	{ _name, offsetof(struct oa_tc6_txq_stats, _member) }
+
+/* Per tx queue, prefixed with txq<n>_ */
+static const struct oa_tc6_stat_desc oa_tc6_txq_stats_desc[] = {
+	OA_TC6_TXQ_STAT("packets", packets),
+	OA_TC6_TXQ_STAT("bytes", bytes),
+	OA_TC6_TXQ_STAT("stopped", stopped),
+};
+
+/* Derived from the bus stats, in per mille */
+static const char oa_tc6_bus_derived_stats[][ETH_GSTRING_LEN] = {
+	"spi_tx_efficiency_permille",	/* Tx payload of all SPI bytes */
+	"spi_rx_efficiency_permille",	/* Rx payload of all SPI bytes */
+	"spi_busy_permille",		/* SPI busy time of elapsed time */
+};
+
+static u64 oa_tc6_permille(u64 part, u64 total)
+{
+	if (!total)
+		return 0;
+
+	return div64_u64(part * 1000, total);
+}
+
+static void oa_tc6_get_bus_derived_stats(struct oa_tc6 *tc6, u64 *data)
+{
+	struct oa_tc6_bus_stats *stats = &tc6->bus_stats;
+
+	data[0] = oa_tc6_permille(stats->tx_payload_bytes, stats->spi_bytes);
+	data[1] = oa_tc6_permille(stats->rx_payload_bytes, stats->spi_bytes);
+	data[2] = oa_tc6_permille(stats->spi_busy_ns,
+				  ktime_get_ns() - tc6->bus_stats_start_ns);
+}
+
+int oa_tc6_get_sset_count(struct oa_tc6 *tc6)
+{
+	return ARRAY_SIZE(oa_tc6_bus_stats_desc) +
+	       ARRAY_SIZE(oa_tc6_bus_derived_stats) +
+	       ARRAY_SIZE(oa_tc6_tx_stats_desc) +
+	       tc6->tx_queues * ARRAY_SIZE(oa_tc6_txq_stats_desc) +
+	       oa_tc6_recovery_get_sset_count();
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_sset_count);
+
+void oa_tc6_get_strings(struct oa_tc6 *tc6, u8 *data)
+{
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_bus_stats_desc); i++) {
+		memcpy(data, oa_tc6_bus_stats_desc[i].name, ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+	memcpy(data, oa_tc6_bus_derived_stats,
+	       sizeof(oa_tc6_bus_derived_stats));
+	data += sizeof(oa_tc6_bus_derived_stats);
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_tx_stats_desc); i++) {
+		memcpy(data, oa_tc6_tx_stats_desc[i].name, ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+	for (int q = 0; q < tc6->tx_queues; q++) {
+		for (int i = 0; i < ARRAY_SIZE(oa_tc6_txq_stats_desc); i++) {
+			snprintf((char *)data, ETH_GSTRING_LEN, "txq%d_%s", q,
+				 oa_tc6_txq_stats_desc[i].name);
+			data += ETH_GSTRING_LEN;
+		}
+	}
+	oa_tc6_recovery_get_strings(data);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_strings);
+
+void oa_tc6_get_ethtool_stats(struct oa_tc6 *tc6, u64 *data)
+{
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_bus_stats_desc); i++)
+		*data++ = *(u64 *)((u8 *)&tc6->bus_stats +
+				   oa_tc6_bus_stats_desc[i].offset);
+	oa_tc6_get_bus_derived_stats(tc6, data);
+	data += ARRAY_SIZE(oa_tc6_bus_derived_stats);
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_tx_stats_desc); i++)
+		*data++ = *(u64 *)((u8 *)&tc6->tx_stats +
+				   oa_tc6_tx_stats_desc[i].offset);
+	for (int q = 0; q < tc6->tx_queues; q++)
+		for (int i = 0; i < ARRAY_SIZE(oa_tc6_txq_stats_desc); i++)
+			*data++ = *(u64 *)((u8 *)&tc6->tx_q_stats[q] +
+					   oa_tc6_txq_stats_desc[i].offset);
+	oa_tc6_recovery_get_stats(tc6, data);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_ethtool_stats);
+
+static int oa_tc6_bus_stats_show(struct seq_file *s, void *unused)
+{
+	u64 derived[ARRAY_SIZE(oa_tc6_bus_derived_stats)];
+	struct oa_tc6 *tc6 = s->private;
+
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_bus_stats_desc); i++)
+		seq_printf(s, "%-28s %llu\n", oa_tc6_bus_stats_desc[i].name,
+			   *(u64 *)((u8 *)&tc6->bus_stats +
+				    oa_tc6_bus_stats_desc[i].offset));
+
+	oa_tc6_get_bus_derived_stats(tc6, derived);
+	for (int i = 0; i < ARRAY_SIZE(oa_tc6_bus_derived_stats); i++)
+		seq_printf(s, "%-28s %llu.%llu%%\n",
+			   oa_tc6_bus_derived_stats[i], derived[i] / 10,
+			   derived[i] % 10);
+
+	return 0;
+}
+
+static int oa_tc6_bus_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, oa_tc6_bus_stats_show, inode->i_private);
+}
+
+/* Writing anything restarts the accounting, e.g. after changing the CPS or
+ * the cut-through configuration. The tc6 task does the reset, between two
+ * data transfers.
+ */
+static ssize_t oa_tc6_bus_stats_write(struct file *file,
+				      const char __user *ubuf, size_t count,
+				      loff_t *ppos)
+{
+	struct oa_tc6 *tc6 = ((struct seq_file *)file->private_data)->private;
+
+	WRITE_ONCE(tc6->bus_stats_reset, true);
+	wake_up_interruptible(&tc6->tc6_wq);
+
+	return count;
+}
+
+static const struct file_operations oa_tc6_bus_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = oa_tc6_bus_stats_open,
+	.read = seq_read,
+	.write = oa_tc6_bus_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void oa_tc6_debugfs_init(struct oa_tc6 *tc6)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "oa_tc6-%s", dev_name(&tc6->spi->dev));
+	tc6->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("bus_stats", 0600, tc6->debugfs, tc6,
+			    &oa_tc6_bus_stats_fops);
+	oa_tc6_trace_debugfs_init(tc6, tc6->debugfs);
+	oa_tc6_sched_debugfs_init(tc6, tc6->debugfs);
+	debugfs_create_u32("txtime_window_ns", 0600, tc6->debugfs,
+			   &tc6->txtime_window_ns);
+	debugfs_create_u64("txtime_delay_ns", 0400, tc6->debugfs,
+			   &tc6->txtime_delay_ns);
+	debugfs_create_u8("rx_ahead_max", 0600, tc6->debugfs,
+			  &tc6->rx_ahead_max);
+}
+
+enum oa_tc6_devlink_param_id {
+	OA_TC6_DEVLINK_PARAM_ID_BASE = DEVLINK_PARAM_GENERIC_ID_MAX,
+	OA_TC6_DEVLINK_PARAM_ID_RX_BUDGET,
+	OA_TC6_DEVLINK_PARAM_ID_TX_BUDGET,
+};
+
+static u8 *oa_tc6_budget(struct devlink *devlink, u32 id)
+{
+	struct oa_tc6 *tc6 = *(struct oa_tc6 **)devlink_priv(devlink);
+
+	if (id == OA_TC6_DEVLINK_PARAM_ID_RX_BUDGET)
+		return &tc6->rx_budget;
+
+	return &tc6->tx_budget;
+}
+
+static int oa_tc6_budget_get(struct devlink *devlink, u32 id,
+			     struct devlink_param_gset_ctx *ctx)
+{
+	ctx->val.vu8 = READ_ONCE(*oa_tc6_budget(devlink, id));
+
+	return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+static int oa_tc6_budget_set(struct devlink *devlink, u32 id,
+			     struct devlink_param_gset_ctx *ctx,
+			     struct netlink_ext_ack *extack)
+#else
+static int oa_tc6_budget_set(struct devlink *devlink, u32 id,
+			     struct devlink_param_gset_ctx *ctx)
+#endif
+{
+	WRITE_ONCE(*oa_tc6_budget(devlink, id), ctx->val.vu8);
+
+	return 0;
+}
+
+static int oa_tc6_budget_validate(struct devlink *devlink, u32 id,
+				  union devlink_param_value val,
+				  struct netlink_ext_ack *extack)
+{
+	if (!val.vu8 || val.vu8 > OA_TC6_MAX_CHUNKS) {
+		NL_SET_ERR_MSG_MOD(extack, "Budget is 1 to 31 chunks");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Chunks each direction may take in one data transfer. Both directions go
+ * in every transfer, so their ratio sets the share of the bus each gets
+ * while both are busy.
+ */
+static const struct devlink_param oa_tc6_devlink_params[] = {
+	DEVLINK_PARAM_DRIVER(OA_TC6_DEVLINK_PARAM_ID_RX_BUDGET, "rx_budget",
+			     DEVLINK_PARAM_TYPE_U8,
+			     BIT(DEVLINK_PARAM_CMODE_RUNTIME),
+			     oa_tc6_budget_get, oa_tc6_budget_set,
+			     oa_tc6_budget_validate),
+	DEVLINK_PARAM_DRIVER(OA_TC6_DEVLINK_PARAM_ID_TX_BUDGET, "tx_budget",
+			     DEVLINK_PARAM_TYPE_U8,
+			     BIT(DEVLINK_PARAM_CMODE_RUNTIME),
+			     oa_tc6_budget_get, oa_tc6_budget_set,
+			     oa_tc6_budget_validate),
+};
+
+int oa_tc6_devlink_params_register(struct oa_tc6 *tc6)
+{
+	*(struct oa_tc6 **)devlink_priv(tc6->devlink) = tc6;
+
+	return devlink_params_register(tc6->devlink, oa_tc6_devlink_params,
+				       ARRAY_SIZE(oa_tc6_devlink_params));
+}
+
+void oa_tc6_devlink_params_unregister(struct oa_tc6 *tc6)
+{
+	devlink_params_unregister(tc6->devlink, oa_tc6_devlink_params,
+				  ARRAY_SIZE(oa_tc6_devlink_params));
+}
+
 struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev)
 {
 	struct oa_tc6 *tc6;
@@ -726,19 +1676,53 @@ struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev)
 
 	tc6->spi = spi;
 	tc6->netdev = netdev;
+	oa_tc6_select_chunk_ops(tc6);
+	tc6->bus_stats_start_ns = ktime_get_ns();
+	tc6->txtime_window_ns = OA_TC6_TXTIME_WINDOW_NS;
+	tc6->rx_ahead_max = OA_TC6_MAX_CHUNKS;
+	tc6->rx_hash_seed = get_random_u32();
+	tc6->rx_budget = OA_TC6_MAX_CHUNKS;
+	tc6->tx_budget = OA_TC6_MAX_CHUNKS;
+	hrtimer_init(&tc6->txtime_timer, CLOCK_TAI, HRTIMER_MODE_ABS);
+	tc6->txtime_timer.function = oa_tc6_txtime_expired;
+	hrtimer_init(&tc6->txc_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	tc6->txc_timer.function = oa_tc6_txc_expired;
+	tc6->tx_queues = min_t(u32, tc6->netdev->num_tx_queues,
+			       OA_TC6_MAX_TX_QUEUES);
+	for (u8 q = 0; q < tc6->tx_queues; q++)
+		skb_queue_head_init(&tc6->tx_q[q]);
+
+	/* Used for triggering the OA TC6 task. Set up before any debugfs or
+	 * sysfs file whose handlers wake the task.
+	 */
+	init_waitqueue_head(&tc6->tc6_wq);
+
+	init_completion(&tc6->rst_complete);
 
-	/* Allocate memory for the tx buffer used for SPI transfer. */
-	tc6->spi_tx_buf = kzalloc(MAX_ETH_LEN + (OA_TC6_MAX_CPS * TC6_HDR_SIZE),
+	/* Allocate memory for the tx buffer used for SPI transfer. Both SPI
+	 * buffers are kept for the lifetime of the device and rounded up to
+	 * whole cachelines, so no other object shares the lines the controller
+	 * transfers into.
+	 */
+	tc6->spi_tx_buf = kzalloc(ALIGN(OA_TC6_SPI_BUF_SIZE,
+					dma_get_cache_alignment()),
 				  GFP_KERNEL);
 	if (!tc6->spi_tx_buf)
 		goto err_spi_tx_buf_alloc;
 
 	/* Allocate memory for the rx buffer used for SPI transfer. */
-	tc6->spi_rx_buf = kzalloc(MAX_ETH_LEN + (OA_TC6_MAX_CPS * TC6_FTR_SIZE),
+	tc6->spi_rx_buf = kzalloc(ALIGN(OA_TC6_SPI_BUF_SIZE,
+					dma_get_cache_alignment()),
 				  GFP_KERNEL);
 	if (!tc6->spi_rx_buf)
 		goto err_spi_rx_buf_alloc;
 
+	/* Prepared messages of the data transfers */
+	tc6->data_msgs = kcalloc(OA_TC6_MAX_CHUNKS, sizeof(*tc6->data_msgs),
+				 GFP_KERNEL);
+	if (!tc6->data_msgs)
+		goto err_data_msgs_alloc;
+
 	/* Allocate memory for the tx ethernet chunks to transfer on SPI. */
 	tc6->eth_tx_buf = kzalloc(MAX_ETH_LEN + (OA_TC6_MAX_CPS * TC6_HDR_SIZE),
 				  GFP_KERNEL);
@@ -751,18 +1735,30 @@ struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev)
 	if (!tc6->eth_rx_buf)
 		goto err_eth_rx_buf_alloc;
 
-	/* Used for triggering the OA TC6 task */
-	init_waitqueue_head(&tc6->tc6_wq);
+	/* Capture ring for the raw SPI transfers, controlled from debugfs */
+	if (oa_tc6_trace_init(tc6))
+		goto err_trace_init;
 
-	init_completion(&tc6->rst_complete);
+	/* Take turns with the other devices on the same SPI controller */
+	if (oa_tc6_sched_join(tc6))
+		goto err_sched_join;
+	oa_tc6_debugfs_init(tc6);
+
+	/* Reset and reconfiguration of a MAC-PHY which lost its configuration */
+	if (oa_tc6_recovery_init(tc6))
+		goto err_recovery_init;
 
 	/* This task performs the SPI transfer */
-	tc6->tc6_task = kthread_run(oa_tc6_handler, tc6, "OA TC6 Task");
+	tc6->tc6_task = kthread_run(oa_tc6_handler, tc6, "oa-tc6/%s",
+				    dev_name(&spi->dev));
 	if (IS_ERR(tc6->tc6_task))
 		goto err_tc6_task;
 
-	/* Set the highest priority to the tc6 task as it is time critical */
-	sched_set_fifo(tc6->tc6_task);
+	/* Real-time by default as the tc6 task is time critical, the policy
+	 * and the CPUs come from the module parameters and sysfs.
+	 */
+	if (oa_tc6_task_init(tc6))
+		goto err_task_init;
 
 	/* Register MAC-PHY interrupt service routine */
 	ret = devm_request_irq(&spi->dev, spi->irq, macphy_irq, 0, "macphy int",
@@ -776,17 +1772,34 @@ struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev)
 	if (oa_tc6_sw_reset(tc6))
 		goto err_macphy_reset;
 
+	if (oa_tc6_phy_irq_init(tc6))
+		goto err_macphy_reset;
+
 	return tc6;
 
 err_macphy_reset:
 	devm_free_irq(&tc6->spi->dev, tc6->spi->irq, tc6);
 err_macphy_irq:
+	oa_tc6_task_deinit(tc6);
+err_task_init:
 	kthread_stop(tc6->tc6_task);
+	hrtimer_cancel(&tc6->txtime_timer);
+	hrtimer_cancel(&tc6->txc_timer);
 err_tc6_task:
+	oa_tc6_recovery_deinit(tc6);
+err_recovery_init:
+	debugfs_remove_recursive(tc6->debugfs);
+	oa_tc6_sched_leave(tc6);
+err_sched_join:
+	oa_tc6_trace_deinit(tc6);
+err_trace_init:
 	kfree(tc6->eth_rx_buf);
 err_eth_rx_buf_alloc:
 	kfree(tc6->eth_tx_buf);
 err_eth_tx_buf_alloc:
+	oa_tc6_data_msgs_release(tc6);
+	kfree(tc6->data_msgs);
+err_data_msgs_alloc:
 	kfree(tc6->spi_rx_buf);
 err_spi_rx_buf_alloc:
 	kfree(tc6->spi_tx_buf);
@@ -798,10 +1811,26 @@ EXPORT_SYMBOL_GPL(oa_tc6_init);
 
 void oa_tc6_deinit(struct oa_tc6 *tc6)
 {
+	oa_tc6_phy_irq_deinit(tc6);
 	devm_free_irq(&tc6->spi->dev, tc6->spi->irq, tc6);
+	oa_tc6_task_deinit(tc6);
 	kthread_stop(tc6->tc6_task);
+	hrtimer_cancel(&tc6->txtime_timer);
+	hrtimer_cancel(&tc6->txc_timer);
+	oa_tc6_recovery_deinit(tc6);
+	debugfs_remove_recursive(tc6->debugfs);
+	if (tc6->fwd)
+		oa_tc6_fwd_deinit(tc6);
+	oa_tc6_sched_leave(tc6);
+	oa_tc6_trace_deinit(tc6);
+	dev_kfree_skb_any(tc6->tx_ts_skb);
+	dev_kfree_skb_any(tc6->tx_skb);
+	for (u8 q = 0; q < tc6->tx_queues; q++)
+		skb_queue_purge(&tc6->tx_q[q]);
 	kfree(tc6->eth_rx_buf);
 	kfree(tc6->eth_tx_buf);
+	oa_tc6_data_msgs_release(tc6);
+	kfree(tc6->data_msgs);
 	kfree(tc6->spi_rx_buf);
 	kfree(tc6->spi_tx_buf);
 	kfree(tc6);
@@ -5,6 +5,9 @@
  * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
  */
 
+#ifndef _OA_TC6_H
+#define _OA_TC6_H
+
 #include <linux/spi/spi.h>
 #include <linux/netdevice.h>
 
@@ -27,6 +30,7 @@
 #define DATA_HDR_SWO	GENMASK(19, 16)	/* Start Word Offset */
 #define DATA_HDR_EV	BIT(14)		/* End Valid */
 #define DATA_HDR_EBO	GENMASK(13, 8)	/* End Byte Offset */
+#define DATA_HDR_TSC	GENMASK(7, 6)	/* Timestamp Capture */
 #define DATA_HDR_P	BIT(0)		/* Header Parity Bit */
 
 /* Data footer */
@@ -40,6 +44,8 @@
 #define DATA_FTR_FD	BIT(15)		/* Frame Drop */
 #define DATA_FTR_EV	BIT(14)		/* End Valid */
 #define DATA_FTR_EBO	GENMASK(13, 8)	/* End Byte Offset */
+#define DATA_FTR_RTSA	BIT(7)		/* Receive Timestamp Added */
+#define DATA_FTR_RTSP	BIT(6)		/* Receive Timestamp Parity */
 #define DATA_FTR_TXC	GENMASK(5, 1)	/* Transmit Credits */
 #define DATA_FTR_P	BIT(0)		/* Footer Parity Bit */
 
@@ -49,6 +55,17 @@
 #define OA_TC6_STS0	0x0008		/* Status Register #0 */
 #define OA_TC6_BUFSTS	0x000B /* Buffer Status Register */
 #define OA_TC6_IMASK0	0x000C		/* Interrupt Mask Register #0 */
+#define OA_TC6_TTSCAH	0x0010		/* Tx Timestamp Capture A (High) */
+#define OA_TC6_TTSCAL	0x0011		/* Tx Timestamp Capture A (Low) */
+
+/* Memory map selectors of the PHY's clause 45 MMDs, in the address bits
+ * 19:16 of a control transaction
+ */
+#define OA_TC6_MMS_SHIFT	16
+#define OA_TC6_MMS_PCS		2
+#define OA_TC6_MMS_PMA_PMD	3
+#define OA_TC6_MMS_VEND2	4	/* Vendor specific and PLCA */
+#define OA_TC6_MMS_AN		5
 
 /* RESET register field */
 #define SW_RESET	BIT(0)		/* Software Reset */
@@ -57,12 +74,18 @@
 #define SYNC		BIT(15)		/* Configuration Synchronization */
 #define TXCTE		BIT(9)		/* Tx cut-through enable */
 #define RXCTE		BIT(8)		/* Rx cut-through enable */
+#define FTSE		BIT(7)		/* Frame Timestamp Enable */
+#define FTSS		BIT(6)		/* Frame Timestamp Select, 64 bit */
 #define PROTE		BIT(5)		/* Ctrl read/write Protection Enable */
 #define CPS		GENMASK(2, 0)	/* Chunk Payload Size */
 
 /* STATUS0 register fields */
 #define CDPE		BIT(12)		/* Control Data Protection Error */
 #define TXFCSE		BIT(11)		/* Transmit Frame Check Sequence Error */
+#define TTSCAC		BIT(10)		/* Tx Timestamp Capture Available C */
+#define TTSCAB		BIT(9)		/* Tx Timestamp Capture Available B */
+#define TTSCAA		BIT(8)		/* Tx Timestamp Capture Available A */
+#define PHYINT		BIT(7)		/* PHY Interrupt */
 #define RESETC		BIT(6)		/* Reset Complete */
 #define HDRE		BIT(5)		/* Header Error */
 #define LOFE		BIT(4)		/* Loss of Framing Error */
@@ -72,6 +95,8 @@
 #define TXPE		BIT(0)		/* Transmit Protocol Error */
 
 /* Unmasking interrupt fields in IMASK0 */
+#define TTSCAAM		~BIT(8)		/* Tx Timestamp Capture A Mask */
+#define PHYINTM		~BIT(7)		/* PHY Interrupt Mask */
 #define HDREM		~BIT(5)		/* Header Error Mask */
 #define LOFEM		~BIT(4)		/* Loss of Framing Error Mask */
 #define RXBOEM		~BIT(3)		/* Rx Buffer Overflow Error Mask */
@@ -92,12 +117,118 @@
 #define FTR_OK		0
 #define FTR_ERR		1
 
+/* Timestamp select for DATA_HDR_TSC */
+#define OA_TC6_TSC_A	1
+
+#define OA_TC6_TS_SIZE	8		/* 64 bit frame timestamp */
+
 #define MAX_ETH_LEN	1536
 #define OA_TC6_MAX_CPS	64
+#define OA_TC6_MAX_CHUNKS	31	/* Largest RCA the footer can report */
+
+/* A data transfer carries at most OA_TC6_MAX_CHUNKS chunks */
+#define OA_TC6_SPI_BUF_SIZE \
+	(OA_TC6_MAX_CHUNKS * (OA_TC6_MAX_CPS + TC6_HDR_SIZE))
+
+/* Tx queues in strict priority, the highest index goes first */
+#define OA_TC6_MAX_TX_QUEUES	4
+#define OA_TC6_TX_QUEUE_LEN	4	/* Frames per queue */
+
+struct devlink;
+struct irq_domain;
+struct devlink_health_reporter;
+struct oa_tc6_fwd;
+struct tc_etf_qopt_offload;
+struct tc_mqprio_qopt_offload;
+struct oa_tc6_sched;
+struct oa_tc6_trace;
+struct oa_tc6_task;
+struct oa_tc6_chunk_ops;
+struct oa_tc6_data_msg;
+
+/* SPI bus usage by category, in bytes clocked on the bus. A chunk goes both
+ * ways at once, the tx and the rx side of a duplex transfer are each
+ * counted, so the categories add up to more than spi_bytes.
+ */
+struct oa_tc6_bus_stats {
+	u64 spi_bytes;		/* All transfers */
+	u64 spi_busy_ns;	/* Time spent in spi_sync() */
+	u64 data_xfers;
+	u64 duplex_xfers;	/* Data transfers carrying tx and rx chunks */
+	u64 ctrl_xfers;
+	u64 tx_payload_bytes;	/* Ethernet frame bytes in tx chunks */
+	u64 tx_pad_bytes;	/* Unused payload of tx chunks */
+	u64 rx_payload_bytes;	/* Ethernet frame bytes in rx chunks */
+	u64 rx_data_chunks;	/* Rx chunks with data valid */
+	u64 empty_bytes;	/* Chunks without data in either direction */
+	u64 hdr_ftr_bytes;	/* Headers/footers of chunks carrying data */
+	u64 ctrl_bytes;		/* Control transactions */
+	u64 ctrl_prot_bytes;	/* Complement words of protected control */
+	u64 sched_grants;	/* Turns granted on a shared SPI bus */
+	u64 sched_wait_ns;	/* Time spent waiting for a turn */
+	u64 sched_max_wait_ns;
+	u64 rx_ahead_xfers;	/* Rx transfers reading ahead of RCA */
+	u64 rx_ahead_saved;	/* ... which received data beyond RCA */
+	u64 rx_ahead_wasted;	/* ... which only got empty chunks beyond */
+	u64 rx_budget_exhausted; /* Transfers with rx chunks left waiting */
+	u64 tx_budget_exhausted; /* Transfers with tx chunks left to send */
+};
+
+struct oa_tc6_tx_stats {
+	u64 txtime_frames;	/* Frames sent at their SO_TXTIME launch time */
+	u64 txtime_late;	/* Done after launch time + window */
+	u64 txtime_early;	/* Done before launch time - window */
+	u64 txtime_max_late_ns;
+	u64 txc_stalls;		/* Times a frame ran out of tx credits */
+	u64 txc_stall_ns;	/* Time spent waiting for tx credits */
+	u64 txc_polls;		/* BUFSTS reads when credits were due */
+	u64 txc_polls_empty;	/* ... which found no credits yet */
+};
+
+/* Cause of an error in the data transfer, see oa_tc6_recovery.c */
+enum oa_tc6_err {
+	OA_TC6_ERR_NONE,
+	OA_TC6_ERR_PARITY,	/* Bad footer parity, SPI glitch */
+	OA_TC6_ERR_OFFSET,	/* Bad start or end offset in a footer */
+	OA_TC6_ERR_STATUS,	/* Error reported in STS0 */
+	OA_TC6_ERR_LOFE,	/* Loss of framing reported in STS0 */
+	OA_TC6_ERR_HDRB,	/* The MAC-PHY received a bad header */
+	OA_TC6_ERR_UNSYNC,	/* The MAC-PHY lost its configuration */
+	OA_TC6_ERR_TX_TIMEOUT,	/* Tx watchdog of the stack */
+	OA_TC6_ERR_REQUEST,	/* Recovery requested through devlink */
+	OA_TC6_ERR_MAX,
+};
+
+struct oa_tc6_err_stats {
+	u64 errors[OA_TC6_ERR_MAX];
+	u64 recoveries;
+	u64 recovery_failures;
+	u64 recovery_last_ns;
+	u64 recovery_max_ns;
+};
+
+/**
+ * struct oa_tc6_recovery_ops - MAC specific state to restore after a reset
+ * @restore_early: before CONFIG0 is synchronized, e.g. the buffer sizes.
+ * @restore: after, e.g. MAC address, filters and PHY setup.
+ *
+ * Both are called by the tc6 task with the data transfer stopped.
+ */
+struct oa_tc6_recovery_ops {
+	int (*restore_early)(struct net_device *netdev);
+	int (*restore)(struct net_device *netdev);
+};
+
+struct oa_tc6_txq_stats {
+	u64 packets;
+	u64 bytes;
+	u64 stopped;		/* Times the queue was full */
+};
 
 struct oa_tc6 {
 	struct completion rst_complete;
 	struct task_struct *tc6_task;
+	struct oa_tc6_task *task;
 	struct net_device *netdev;
 	wait_queue_head_t tc6_wq;
 	struct spi_device *spi;
@@ -109,6 +240,7 @@ struct oa_tc6 {
 	bool ctrl_prot;
 	u8 *spi_tx_buf;
 	u8 *spi_rx_buf;
+	struct oa_tc6_data_msg *data_msgs;
 	u8 *eth_tx_buf;
 	u8 *eth_rx_buf;
 	bool int_flag;
@@ -117,8 +249,70 @@ struct oa_tc6 {
 	bool tx_flag;
 	bool reset;
 	u8 cps;
+	const struct oa_tc6_chunk_ops *chunk_ops;
 	u8 txc;
 	u8 rca;
+	struct dentry *debugfs;
+	struct oa_tc6_trace *trace;
+	bool trace_enabled;
+	struct oa_tc6_bus_stats bus_stats;
+	u64 bus_stats_start_ns;
+	bool bus_stats_reset;		/* Reset requested from debugfs */
+	struct oa_tc6_sched *sched;
+	struct list_head sched_node;
+	u32 sched_weight;
+	s32 sched_deficit;
+	bool sched_waiting;
+	u8 sched_index;
+	struct oa_tc6_fwd *fwd;
+	u32 config0;
+	bool hwts_tx_en;
+	bool hwts_rx_en;
+	struct sk_buff *tx_ts_skb;	/* Waiting for its tx timestamp */
+	unsigned long tx_ts_start;
+	bool rx_ts_added;
+	bool rx_ts_parity;
+	bool rx_ts_valid;
+	u64 rx_ts;			/* Of the frame in eth_rx_buf, ns */
+	bool rx_csum_en;
+	bool rx_csum_valid;
+	__wsum rx_csum;			/* Of the frame in eth_rx_buf */
+	bool rx_hash_en;
+	u8 rx_hash_type;		/* enum pkt_hash_types of rx_hash */
+	u32 rx_hash;			/* Flow hash of the frame in eth_rx_buf */
+	u32 rx_hash_seed;
+	u8 txtime_queues;		/* Queues with ETF offload */
+	u8 txtime_held;			/* Queues with a frame held */
+	u64 tx_launch_ns;		/* Of tx_skb, CLOCK_TAI, 0 if none */
+	u64 tx_release_ns;		/* When tx_skb was released to the bus */
+	u64 txtime_delay_ns;		/* Measured release to done delay */
+	u32 txtime_window_ns;
+	struct hrtimer txtime_timer;
+	struct hrtimer txc_timer;	/* Credits of the stalled tx are due */
+	u64 txc_stall_start_ns;		/* Of the credit stall, 0 if none */
+	u8 txc_polls;			/* BUFSTS reads in this stall */
+	bool txc_poll;
+	struct oa_tc6_tx_stats tx_stats;
+	u8 tx_queues;
+	struct sk_buff_head tx_q[OA_TC6_MAX_TX_QUEUES];
+	struct oa_tc6_txq_stats tx_q_stats[OA_TC6_MAX_TX_QUEUES];
+	u32 imask0;
+	u8 rx_err;			/* enum oa_tc6_err of the last FTR_ERR */
+	u8 err_streak;			/* Errors since the last good transfer */
+	u32 recovery_req;		/* enum oa_tc6_err, from other contexts */
+	struct completion recovery_done;
+	const struct oa_tc6_recovery_ops *recovery_ops;
+	struct oa_tc6_err_stats err_stats;
+	struct devlink *devlink;
+	struct devlink_health_reporter *health;
+	struct irq_domain *phy_irq_domain;
+	int phy_irq;			/* Demultiplexed from STS0.PHYINT */
+	bool phy_irq_masked;
+	u8 rx_ahead_max;		/* Chunks read without knowing RCA */
+	u16 rx_burst_chunks;		/* Data chunks of the current rx burst */
+	u16 rx_burst_avg;		/* Moving average of the bursts, 1/8 */
+	u8 rx_budget;			/* Rx chunks per transfer at most */
+	u8 tx_budget;			/* Tx chunks per transfer at most */
 };
 
 struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev);
@@ -127,4 +321,26 @@ int oa_tc6_write_register(struct oa_tc6 *tc6, u32 addr, u32 value[], u8 len);
 int oa_tc6_read_register(struct oa_tc6 *tc6, u32 addr, u32 value[], u8 len);
 int oa_tc6_configure(struct oa_tc6 *tc6, u8 cps, bool ctrl_prot, bool tx_cut_thr,
 		     bool rx_cut_thr);
+void oa_tc6_set_sched_weight(struct oa_tc6 *tc6, u32 weight);
+void oa_tc6_set_recovery_ops(struct oa_tc6 *tc6,
+			     const struct oa_tc6_recovery_ops *ops);
+void oa_tc6_request_recovery(struct oa_tc6 *tc6);
+int oa_tc6_get_phy_irq(struct oa_tc6 *tc6);
+int oa_tc6_suspend(struct oa_tc6 *tc6);
+int oa_tc6_resume(struct oa_tc6 *tc6);
+int oa_tc6_enable_forwarding(struct oa_tc6 *tc6, struct device_node *peer_np);
+int oa_tc6_hwtstamp_set(struct oa_tc6 *tc6, struct ifreq *ifr);
+int oa_tc6_hwtstamp_get(struct oa_tc6 *tc6, struct ifreq *ifr);
+void oa_tc6_set_rx_csum(struct oa_tc6 *tc6, bool enable);
+void oa_tc6_set_rx_hash(struct oa_tc6 *tc6, bool enable);
+int oa_tc6_setup_etf(struct oa_tc6 *tc6, struct tc_etf_qopt_offload *qopt);
+int oa_tc6_setup_mqprio(struct oa_tc6 *tc6,
+			struct tc_mqprio_qopt_offload *mqprio);
+u16 oa_tc6_select_queue(struct oa_tc6 *tc6, struct sk_buff *skb,
+			struct net_device *sb_dev);
 netdev_tx_t oa_tc6_send_eth_pkt(struct oa_tc6 *tc6, struct sk_buff *skb);
+int oa_tc6_get_sset_count(struct oa_tc6 *tc6);
+void oa_tc6_get_strings(struct oa_tc6 *tc6, u8 *data);
+void oa_tc6_get_ethtool_stats(struct oa_tc6 *tc6, u64 *data);
+
+#endif /* _OA_TC6_H */
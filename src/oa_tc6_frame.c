@@ -0,0 +1,611 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface framing core
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/bitfield.h>
+#include <linux/if_vlan.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/jhash.h>
+#include <net/checksum.h>
+#include <net/ip.h>
+#include <net/ipv6.h>
+#include "oa_tc6_frame.h"
+
+u16 oa_tc6_ctrl_size(u8 len, bool ctrl_prot)
+{
+	if (ctrl_prot)
+		return (TC6_HDR_SIZE * 2) + (len * (TC6_HDR_SIZE * 2));
+
+	return (TC6_HDR_SIZE * 2) + (len * TC6_HDR_SIZE);
+}
+
+/* The control framing helpers are instantiated once per protection mode so
+ * that the per register stride and the protected checks are resolved at
+ * compile time. The mode is a per call parameter as reset and recovery
+ * issue both framings, so the dispatch happens once per transaction.
+ */
+static __always_inline void
+__oa_tc6_prepare_ctrl_buf(u32 addr, u32 val[], u8 len, bool wnr, u8 *buf,
+			  const bool ctrl_prot)
+{
+	u32 hdr;
+
+	/* Prepare the control header with the required details */
+	hdr = FIELD_PREP(CTRL_HDR_DNC, 0) |
+	      FIELD_PREP(CTRL_HDR_WNR, wnr) |
+	      FIELD_PREP(CTRL_HDR_AID, 0) |
+	      FIELD_PREP(CTRL_HDR_MMS, addr >> 16) |
+	      FIELD_PREP(CTRL_HDR_ADDR, addr) |
+	      FIELD_PREP(CTRL_HDR_LEN, len - 1);
+	hdr |= FIELD_PREP(CTRL_HDR_P, oa_tc6_get_parity(hdr));
+	*(u32 *)&buf[0] = cpu_to_be32(hdr);
+
+	if (wnr) {
+		for (u8 i = 0; i < len; i++) {
+			u16 pos;
+
+			if (!ctrl_prot) {
+				/* Send the value to be written followed by the
+				 * header.
+				 */
+				pos = TC6_HDR_SIZE + (i * TC6_HDR_SIZE);
+				*(u32 *)&buf[pos] = cpu_to_be32(val[i]);
+			} else {
+				/* If protected then send complemented value
+				 * also followed by actual value.
+				 */
+				pos = TC6_HDR_SIZE + (i * (TC6_HDR_SIZE * 2));
+				*(u32 *)&buf[pos] = cpu_to_be32(val[i]);
+				pos = (TC6_HDR_SIZE * 2) +
+				      (i * (TC6_HDR_SIZE * 2));
+				*(u32 *)&buf[pos] = cpu_to_be32(~val[i]);
+			}
+		}
+	}
+}
+
+void oa_tc6_prepare_ctrl_buf(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
+			     bool wnr, u8 *buf, bool ctrl_prot)
+{
+	if (ctrl_prot)
+		__oa_tc6_prepare_ctrl_buf(addr, val, len, wnr, buf, true);
+	else
+		__oa_tc6_prepare_ctrl_buf(addr, val, len, wnr, buf, false);
+}
+
+static __always_inline int
+__oa_tc6_check_control(u8 *ptx, u8 *prx, u8 len, bool wnr,
+		       const bool ctrl_prot)
+{
+	/* 1st 4 bytes of rx chunk data can be discarded */
+	u32 rx_hdr = *(u32 *)&prx[TC6_HDR_SIZE];
+	u32 tx_hdr = *(u32 *)&ptx[0];
+	u32 rx_data_complement;
+	u32 tx_data;
+	u32 rx_data;
+	u16 pos;
+
+	/* If tx hdr and echoed hdr are not equal then there might be an issue
+	 * with the connection between SPI host and MAC-PHY. Here this case is
+	 * considered as MAC-PHY is not connected.
+	 */
+	if (tx_hdr != rx_hdr)
+		return -ENODEV;
+
+	if (wnr) {
+		if (!ctrl_prot) {
+			/* In case of ctrl write, both tx data & echoed
+			 * data are compared for the error.
+			 */
+			for (u8 i = 0; i < len; i++) {
+				pos = TC6_HDR_SIZE + (i * TC6_HDR_SIZE);
+				tx_data = *(u32 *)&ptx[pos];
+				pos = (TC6_HDR_SIZE * 2) + (i * TC6_HDR_SIZE);
+				rx_data = *(u32 *)&prx[pos];
+				if (tx_data != rx_data)
+					return -ENODEV;
+			}
+			goto exit;
+		} else {
+			goto check_rx_data;
+		}
+	} else {
+		if (ctrl_prot)
+			goto check_rx_data;
+		else
+			goto exit;
+	}
+
+check_rx_data:
+	/* In case of ctrl read or ctrl write in protected mode, the rx data and
+	 * the complement of rx data are compared for the error.
+	 */
+	for (u8 i = 0; i < len; i++) {
+		pos = (TC6_HDR_SIZE * 2) + (i * (TC6_HDR_SIZE * 2));
+		rx_data = *(u32 *)&prx[pos];
+		pos = (TC6_HDR_SIZE * 3) + (i * (TC6_HDR_SIZE * 2));
+		rx_data_complement = *(u32 *)&prx[pos];
+		if (rx_data != ~rx_data_complement)
+			return -ENODEV;
+	}
+exit:
+	return 0;
+}
+
+int oa_tc6_check_control(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u8 len,
+			 bool wnr, bool ctrl_prot)
+{
+	if (ctrl_prot)
+		return __oa_tc6_check_control(ptx, prx, len, wnr, true);
+
+	return __oa_tc6_check_control(ptx, prx, len, wnr, false);
+}
+
+static __always_inline void
+__oa_tc6_copy_ctrl_data(u8 *prx, u32 val[], u8 len, const bool ctrl_prot)
+{
+	u16 pos;
+
+	/* Copy read data from the rx data in case of ctrl read */
+	for (u8 i = 0; i < len; i++) {
+		if (!ctrl_prot) {
+			pos = (TC6_HDR_SIZE * 2) + (i * TC6_HDR_SIZE);
+			val[i] = be32_to_cpu(*(u32 *)&prx[pos]);
+		} else {
+			pos = (TC6_HDR_SIZE * 2) + (i * (TC6_HDR_SIZE * 2));
+			val[i] = be32_to_cpu(*(u32 *)&prx[pos]);
+		}
+	}
+}
+
+void oa_tc6_copy_ctrl_data(u8 *prx, u32 val[], u8 len, bool ctrl_prot)
+{
+	if (ctrl_prot)
+		__oa_tc6_copy_ctrl_data(prx, val, len, true);
+	else
+		__oa_tc6_copy_ctrl_data(prx, val, len, false);
+}
+
+/* The chunk loops below are instantiated for each chunk payload size with
+ * the size as a constant, so that the chunk offsets are constant strides
+ * instead of multiplications and divisions by tc6->cps. cps is one of the
+ * constants or tc6->cps itself for the generic instance.
+ */
+static __always_inline u16 __oa_tc6_prepare_empty_chunk(u8 *buf, u8 cp_count,
+							const u16 cps)
+{
+	/* The empty chunk header never changes */
+	const __be32 hdr = oa_tc6_data_hdr(FIELD_PREP(DATA_HDR_DNC, 1));
+
+	/* Prepare empty chunks used for getting interrupt information or if
+	 * receive data available.
+	 */
+	for (u8 i = 0; i < cp_count; i++) {
+		*(__be32 *)&buf[i * (cps + TC6_HDR_SIZE)] = hdr;
+		memset(&buf[TC6_HDR_SIZE + (i * (cps + TC6_HDR_SIZE))], 0, cps);
+	}
+
+	return cp_count * (cps + TC6_HDR_SIZE);
+}
+
+/* tsc selects the TTSCx register capturing the tx timestamp of the frame,
+ * 0 for none.
+ */
+static __always_inline void
+__oa_tc6_prepare_tx_chunks(struct oa_tc6 *tc6, u8 *buf, const u8 *data,
+			   u16 len, u8 tsc, const u16 cps)
+{
+	/* Middle of frame chunks all share the same header, only the first
+	 * and the last chunk need their own parity.
+	 */
+	const u32 mid_hdr = FIELD_PREP(DATA_HDR_DNC, 1) |
+			    FIELD_PREP(DATA_HDR_DV, 1);
+	const __be32 mid_hdr_be = oa_tc6_data_hdr(mid_hdr);
+	u16 copied_bytes = 0;
+	u16 copy_len;
+	u32 hdr;
+
+	/* Calculate the number tx credit counts needed to transport the tx
+	 * ethernet frame.
+	 */
+	tc6->txc_needed = (len / cps) + ((len % cps) ? 1 : 0);
+	tc6->total_txc_needed = tc6->txc_needed;
+
+	for (u8 i = 0; i < tc6->txc_needed; i++) {
+		/* Prepare the header for each chunks to be transmitted */
+		hdr = mid_hdr;
+		if (!i)
+			hdr |= FIELD_PREP(DATA_HDR_SV, 1) |
+			       FIELD_PREP(DATA_HDR_SWO, 0) |
+			       FIELD_PREP(DATA_HDR_TSC, tsc);
+		if ((cps + copied_bytes) >= len) {
+			copy_len = len - copied_bytes;
+			hdr |= FIELD_PREP(DATA_HDR_EBO, copy_len - 1) |
+			       FIELD_PREP(DATA_HDR_EV, 1);
+		} else {
+			copy_len = cps;
+		}
+		copied_bytes += copy_len;
+		*(__be32 *)&buf[i * (cps + TC6_HDR_SIZE)] =
+			hdr == mid_hdr ? mid_hdr_be : oa_tc6_data_hdr(hdr);
+		/* Copy the ethernet frame in the chunk payload section */
+		memcpy(&buf[TC6_HDR_SIZE + (i * (cps + TC6_HDR_SIZE))],
+		       &data[copied_bytes - copy_len], copy_len);
+	}
+}
+
+/* Append payload[start..end) to the ethernet frame being received. SWO and
+ * EBO come straight from the MAC-PHY footer, so they are validated against
+ * the chunk payload size and the rx buffer before copying. The checksum of
+ * the frame is summed up in the same pass.
+ */
+static bool oa_tc6_rx_append(struct oa_tc6 *tc6, u8 *payload, u16 start,
+			     u16 end, u16 cps)
+{
+	__wsum csum;
+
+	if (start >= end || end > cps ||
+	    tc6->rxd_bytes + (end - start) > MAX_ETH_LEN)
+		return false;
+
+	if (tc6->rx_csum_valid) {
+		csum = csum_partial_copy_nocheck(&payload[start],
+						 &tc6->eth_rx_buf[tc6->rxd_bytes],
+						 end - start);
+		tc6->rx_csum = csum_block_add(tc6->rx_csum, csum,
+					      tc6->rxd_bytes);
+	} else {
+		memcpy(&tc6->eth_rx_buf[tc6->rxd_bytes], &payload[start],
+		       end - start);
+	}
+	tc6->rxd_bytes += end - start;
+	tc6->bus_stats.rx_payload_bytes += end - start;
+
+	return true;
+}
+
+static void oa_tc6_rx_frame_start(struct oa_tc6 *tc6, u32 ftr)
+{
+	tc6->rxd_bytes = 0;
+	tc6->rx_eth_started = true;
+	tc6->rx_ts_added = FIELD_GET(DATA_FTR_RTSA, ftr);
+	tc6->rx_ts_parity = FIELD_GET(DATA_FTR_RTSP, ftr);
+	tc6->rx_csum_valid = tc6->rx_csum_en;
+	tc6->rx_csum = 0;
+}
+
+/* The MAC-PHY puts the 64 bit rx timestamp, seconds and nanoseconds, in
+ * front of the frame if RTSA is set in the footer of its first chunk.
+ */
+static void oa_tc6_rx_strip_ts(struct oa_tc6 *tc6)
+{
+	u32 sec = be32_to_cpu(*(u32 *)&tc6->eth_rx_buf[0]);
+	u32 nsec = be32_to_cpu(*(u32 *)&tc6->eth_rx_buf[4]);
+
+	if (oa_tc6_get_parity(sec ^ nsec) == tc6->rx_ts_parity) {
+		tc6->rx_ts = (u64)sec * NSEC_PER_SEC + nsec;
+		tc6->rx_ts_valid = true;
+	} else {
+		netdev_warn(tc6->netdev, "Footer: Rx timestamp parity error\n");
+	}
+	if (tc6->rx_csum_valid)
+		tc6->rx_csum = csum_sub(tc6->rx_csum,
+					csum_partial(tc6->eth_rx_buf,
+						     OA_TC6_TS_SIZE, 0));
+	tc6->rxd_bytes -= OA_TC6_TS_SIZE;
+	memmove(&tc6->eth_rx_buf[0], &tc6->eth_rx_buf[OA_TC6_TS_SIZE],
+		tc6->rxd_bytes);
+}
+
+/* Flow hash of the frame in eth_rx_buf for RPS and RFS, over the addresses
+ * and, for TCP and UDP, the ports. The headers are still in the cache from
+ * the reassembly, and with the hash set the stack doesn't dissect the frame
+ * again. The IP header is only 2 byte aligned behind the ethernet header,
+ * so the addresses are copied out.
+ */
+static void oa_tc6_rx_flow_hash(struct oa_tc6 *tc6)
+{
+	const u8 *buf = tc6->eth_rx_buf;
+	struct in6_addr addr6;
+	u16 off = ETH_HLEN;
+	u32 saddr, daddr;
+	u32 ports = 0;
+	__be16 proto;
+	u8 l4proto;
+
+	proto = ((const struct ethhdr *)buf)->h_proto;
+	if (proto == htons(ETH_P_8021Q)) {
+		if (tc6->rxd_bytes < off + VLAN_HLEN)
+			return;
+		proto = *(const __be16 *)&buf[off + 2];
+		off += VLAN_HLEN;
+	}
+
+	if (proto == htons(ETH_P_IP)) {
+		const struct iphdr *iph = (const struct iphdr *)&buf[off];
+
+		if (tc6->rxd_bytes < off + sizeof(*iph) || iph->ihl < 5)
+			return;
+		memcpy(&saddr, &iph->saddr, sizeof(saddr));
+		memcpy(&daddr, &iph->daddr, sizeof(daddr));
+		/* Only the first fragment carries the ports */
+		l4proto = ip_is_fragment(iph) ? 0 : iph->protocol;
+		off += iph->ihl * 4;
+	} else if (proto == htons(ETH_P_IPV6)) {
+		const struct ipv6hdr *ip6h = (const struct ipv6hdr *)&buf[off];
+
+		if (tc6->rxd_bytes < off + sizeof(*ip6h))
+			return;
+		memcpy(&addr6, &ip6h->saddr, sizeof(addr6));
+		saddr = ipv6_addr_hash(&addr6);
+		memcpy(&addr6, &ip6h->daddr, sizeof(addr6));
+		daddr = ipv6_addr_hash(&addr6);
+		l4proto = ip6h->nexthdr;
+		off += sizeof(*ip6h);
+	} else {
+		return;
+	}
+
+	tc6->rx_hash_type = PKT_HASH_TYPE_L3;
+	if ((l4proto == IPPROTO_TCP || l4proto == IPPROTO_UDP) &&
+	    tc6->rxd_bytes >= off + sizeof(ports)) {
+		memcpy(&ports, &buf[off], sizeof(ports));
+		tc6->rx_hash_type = PKT_HASH_TYPE_L4;
+	}
+	tc6->rx_hash = jhash_3words(saddr, daddr, ports,
+				    tc6->rx_hash_seed ^ l4proto);
+}
+
+static void oa_tc6_rx_frame_done(struct oa_tc6 *tc6)
+{
+	if (tc6->rx_ts_added && tc6->rxd_bytes >= OA_TC6_TS_SIZE)
+		oa_tc6_rx_strip_ts(tc6);
+
+	tc6->rx_hash_type = PKT_HASH_TYPE_NONE;
+	if (tc6->rx_hash_en && tc6->rxd_bytes >= ETH_HLEN)
+		oa_tc6_rx_flow_hash(tc6);
+
+	/* A frame shorter than the ethernet header can't be passed to the
+	 * network layer.
+	 */
+	if (tc6->rxd_bytes < ETH_HLEN) {
+		tc6->netdev->stats.rx_length_errors++;
+		tc6->netdev->stats.rx_dropped++;
+	} else {
+		oa_tc6_rx_eth_ready(tc6);
+	}
+	tc6->rxd_bytes = 0;
+	tc6->rx_eth_started = false;
+	tc6->rx_ts_valid = false;
+	tc6->rx_csum_valid = false;
+}
+
+/* Footers with a parity error, EXST, HDRB or a cleared SYNC need the slow
+ * path of oa_tc6_process_rx_chunks(). Returns the index of the next such
+ * footer from chunk i on, or cp_count if the rest of the transfer is clean,
+ * so that the common case validates all footers in one tight pass.
+ */
+static __always_inline u8 oa_tc6_next_bad_ftr(u8 *buf, u8 i, u8 cp_count,
+					      const u16 cps)
+{
+	const u32 mask = DATA_FTR_EXST | DATA_FTR_HDRB | DATA_FTR_SYNC;
+	u32 ftr;
+
+	for (; i < cp_count; i++) {
+		ftr = be32_to_cpu(*(__be32 *)&buf[cps +
+						  (i * (cps + TC6_FTR_SIZE))]);
+		if ((ftr & mask) != DATA_FTR_SYNC || oa_tc6_get_parity(ftr))
+			break;
+	}
+
+	return i;
+}
+
+static __always_inline int
+__oa_tc6_process_rx_chunks(struct oa_tc6 *tc6, u8 *buf, u16 len,
+			   const u16 cps)
+{
+	u8 cp_count;
+	u8 bad_ftr;
+	int ret;
+	u32 ftr;
+	u8 *payload;
+	u16 ebo;
+	u16 sbo;
+
+	/* Calculate the number of chunks received */
+	cp_count = len / (cps + TC6_FTR_SIZE);
+	bad_ftr = oa_tc6_next_bad_ftr(buf, 0, cp_count, cps);
+
+	for (u8 i = 0; i < cp_count; i++) {
+		/* Get the footer and payload */
+		ftr = *(u32 *)&buf[cps + (i * (cps + TC6_FTR_SIZE))];
+		ftr = be32_to_cpu(ftr);
+		payload = &buf[(i * (cps + TC6_FTR_SIZE))];
+		if (unlikely(i == bad_ftr)) {
+			bad_ftr = oa_tc6_next_bad_ftr(buf, i + 1, cp_count,
+						      cps);
+			/* Check for footer parity error */
+			if (oa_tc6_get_parity(ftr)) {
+				netdev_err(tc6->netdev, "Footer: Parity error\n");
+				tc6->rx_err = OA_TC6_ERR_PARITY;
+				goto err_exit;
+			}
+			/* If EXST set in the footer then read STS0 register
+			 * to get the status information.
+			 */
+			if (FIELD_GET(DATA_FTR_EXST, ftr)) {
+				ret = oa_tc6_process_exst(tc6);
+				if (ret < 0) {
+					netdev_err(tc6->netdev, "Failed to process EXST\n");
+					tc6->rx_err = OA_TC6_ERR_STATUS;
+				}
+				if (ret)
+					goto err_exit;
+			}
+			if (FIELD_GET(DATA_FTR_HDRB, ftr)) {
+				netdev_err(tc6->netdev, "Footer: Received header bad\n");
+				tc6->rx_err = OA_TC6_ERR_HDRB;
+				goto err_exit;
+			}
+			if (!FIELD_GET(DATA_FTR_SYNC, ftr)) {
+				netdev_err(tc6->netdev, "Footer: Configuration unsync\n");
+				tc6->rx_err = OA_TC6_ERR_UNSYNC;
+				goto err_exit;
+			}
+		}
+		if (FIELD_GET(DATA_FTR_DV, ftr))
+			tc6->bus_stats.rx_data_chunks++;
+		/* If Frame Drop is set, indicates that the MAC has detected a
+		 * condition for which the SPI host should drop the received
+		 * ethernet frame.
+		 */
+		if (FIELD_GET(DATA_FTR_FD, ftr) && FIELD_GET(DATA_FTR_EV, ftr)) {
+			netdev_warn(tc6->netdev, "Footer: Frame drop\n");
+			if (FIELD_GET(DATA_FTR_SV, ftr)) {
+				goto start_new_frame;
+			} else {
+				if (tc6->rx_eth_started) {
+					tc6->rxd_bytes = 0;
+					tc6->rx_eth_started = false;
+					tc6->netdev->stats.rx_dropped++;
+				}
+				continue;
+			}
+		}
+		/* Check for data valid */
+		if (FIELD_GET(DATA_FTR_DV, ftr)) {
+			/* Check whether both start valid and end valid are in a
+			 * single chunk payload means a single chunk payload may
+			 * contain an entire ethernet frame.
+			 */
+			if (FIELD_GET(DATA_FTR_SV, ftr) &&
+			    FIELD_GET(DATA_FTR_EV, ftr)) {
+				sbo = FIELD_GET(DATA_FTR_SWO, ftr) * 4;
+				ebo = FIELD_GET(DATA_FTR_EBO, ftr) + 1;
+				if (ebo <= sbo) {
+					/* End of the ongoing frame followed by
+					 * the start of the next one.
+					 */
+					if (tc6->rx_eth_started) {
+						if (!oa_tc6_rx_append(tc6, payload,
+								      0, ebo, cps))
+							goto err_offset;
+						oa_tc6_rx_frame_done(tc6);
+					}
+					oa_tc6_rx_frame_start(tc6, ftr);
+					if (!oa_tc6_rx_append(tc6, payload, sbo,
+							      cps, cps))
+						goto err_offset;
+					goto exit;
+				} else {
+					if (tc6->rx_eth_started)
+						tc6->netdev->stats.rx_dropped++;
+					oa_tc6_rx_frame_start(tc6, ftr);
+					if (!oa_tc6_rx_append(tc6, payload, sbo,
+							      ebo, cps))
+						goto err_offset;
+					oa_tc6_rx_frame_done(tc6);
+					goto exit;
+				}
+			}
+start_new_frame:
+			/* Check for start valid to start capturing the incoming
+			 * ethernet frame.
+			 */
+			if (FIELD_GET(DATA_FTR_SV, ftr) && !tc6->rx_eth_started) {
+				oa_tc6_rx_frame_start(tc6, ftr);
+				sbo = FIELD_GET(DATA_FTR_SWO, ftr) * 4;
+				if (!oa_tc6_rx_append(tc6, payload, sbo,
+						      cps, cps))
+					goto err_offset;
+				goto exit;
+			}
+
+			/* Check for end valid and calculate the copy length */
+			if (tc6->rx_eth_started) {
+				if (FIELD_GET(DATA_FTR_EV, ftr))
+					ebo = FIELD_GET(DATA_FTR_EBO, ftr) + 1;
+				else
+					ebo = cps;
+
+				if (!oa_tc6_rx_append(tc6, payload, 0, ebo,
+						      cps))
+					goto err_offset;
+				if (FIELD_GET(DATA_FTR_EV, ftr)) {
+					/* If End Valid set then send the
+					 * received ethernet frame to n/w.
+					 */
+					oa_tc6_rx_frame_done(tc6);
+				}
+			}
+		}
+
+exit:
+		tc6->txc = FIELD_GET(DATA_FTR_TXC, ftr);
+		tc6->rca = FIELD_GET(DATA_FTR_RCA, ftr);
+	}
+	return FTR_OK;
+
+err_offset:
+	netdev_err(tc6->netdev, "Footer: Invalid frame offset or length\n");
+	tc6->netdev->stats.rx_length_errors++;
+	tc6->rx_err = OA_TC6_ERR_OFFSET;
+err_exit:
+	if (tc6->rx_eth_started) {
+		tc6->rxd_bytes = 0;
+		tc6->rx_eth_started = false;
+		tc6->netdev->stats.rx_dropped++;
+	}
+	return FTR_ERR;
+}
+
+#define OA_TC6_CHUNK_OPS(name, cps)					\
+static u16 oa_tc6_prepare_empty_chunk_##name(struct oa_tc6 *tc6,	\
+					     u8 *buf, u8 cp_count)	\
+{									\
+	return __oa_tc6_prepare_empty_chunk(buf, cp_count, cps);	\
+}									\
+									\
+static void oa_tc6_prepare_tx_chunks_##name(struct oa_tc6 *tc6,	\
+					    u8 *buf, const u8 *data,	\
+					    u16 len, u8 tsc)		\
+{									\
+	__oa_tc6_prepare_tx_chunks(tc6, buf, data, len, tsc, cps);	\
+}									\
+									\
+static int oa_tc6_process_rx_chunks_##name(struct oa_tc6 *tc6,		\
+					   u8 *buf, u16 len)		\
+{									\
+	return __oa_tc6_process_rx_chunks(tc6, buf, len, cps);		\
+}									\
+									\
+static const struct oa_tc6_chunk_ops oa_tc6_chunk_ops_##name = {	\
+	.prepare_empty_chunk = oa_tc6_prepare_empty_chunk_##name,	\
+	.prepare_tx_chunks = oa_tc6_prepare_tx_chunks_##name,		\
+	.process_rx_chunks = oa_tc6_process_rx_chunks_##name,		\
+}
+
+OA_TC6_CHUNK_OPS(32, 32);
+OA_TC6_CHUNK_OPS(64, 64);
+OA_TC6_CHUNK_OPS(generic, tc6->cps);
+
+/* The chunk payload sizes of the supported MAC-PHYs get their own loops */
+void oa_tc6_select_chunk_ops(struct oa_tc6 *tc6)
+{
+	switch (tc6->cps) {
+	case 32:
+		tc6->chunk_ops = &oa_tc6_chunk_ops_32;
+		break;
+	case 64:
+		tc6->chunk_ops = &oa_tc6_chunk_ops_64;
+		break;
+	default:
+		tc6->chunk_ops = &oa_tc6_chunk_ops_generic;
+		break;
+	}
+}
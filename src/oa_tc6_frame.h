@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface framing core
+ *
+ * Chunk building, footer parsing, frame reassembly and control framing.
+ * This part of the framework doesn't touch the SPI bus or the network
+ * stack directly so that it can also be built in userspace (see
+ * tools/oa_tc6) for fuzzing and profiling.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_FRAME_H
+#define _OA_TC6_FRAME_H
+
+#include <linux/bitfield.h>
+#include <linux/bitops.h>
+#include "oa_tc6.h"
+
+/* Returns the odd parity bit for p. hweight32() is a single popcount on
+ * most architectures and folds to a constant for constant headers.
+ */
+static inline bool oa_tc6_get_parity(u32 p)
+{
+	return !(hweight32(p) & 1);
+}
+
+/* Adds the parity bit to a data chunk header and converts it to wire order */
+static inline __be32 oa_tc6_data_hdr(u32 hdr)
+{
+	return cpu_to_be32(hdr | FIELD_PREP(DATA_HDR_P,
+					    oa_tc6_get_parity(hdr)));
+}
+u16 oa_tc6_ctrl_size(u8 len, bool ctrl_prot);
+void oa_tc6_prepare_ctrl_buf(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
+			     bool wnr, u8 *buf, bool ctrl_prot);
+int oa_tc6_check_control(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u8 len,
+			 bool wnr, bool ctrl_prot);
+void oa_tc6_copy_ctrl_data(u8 *prx, u32 val[], u8 len, bool ctrl_prot);
+
+/* Chunk loops specialized for the configured chunk payload size, selected
+ * by oa_tc6_select_chunk_ops() whenever tc6->cps changes.
+ */
+struct oa_tc6_chunk_ops {
+	u16 (*prepare_empty_chunk)(struct oa_tc6 *tc6, u8 *buf, u8 cp_count);
+	void (*prepare_tx_chunks)(struct oa_tc6 *tc6, u8 *buf, const u8 *data,
+				  u16 len, u8 tsc);
+	int (*process_rx_chunks)(struct oa_tc6 *tc6, u8 *buf, u16 len);
+};
+
+void oa_tc6_select_chunk_ops(struct oa_tc6 *tc6);
+
+static inline u16 oa_tc6_prepare_empty_chunk(struct oa_tc6 *tc6, u8 *buf,
+					     u8 cp_count)
+{
+	return tc6->chunk_ops->prepare_empty_chunk(tc6, buf, cp_count);
+}
+
+static inline void oa_tc6_prepare_tx_chunks(struct oa_tc6 *tc6, u8 *buf,
+					    const u8 *data, u16 len, u8 tsc)
+{
+	tc6->chunk_ops->prepare_tx_chunks(tc6, buf, data, len, tsc);
+}
+
+static inline int oa_tc6_process_rx_chunks(struct oa_tc6 *tc6, u8 *buf,
+					   u16 len)
+{
+	return tc6->chunk_ops->process_rx_chunks(tc6, buf, len);
+}
+
+/* Provided by the user of the framing core: oa_tc6.c in the kernel and the
+ * harnesses in tools/oa_tc6 in userspace. oa_tc6_process_exst() returns 0 if
+ * the extended status was informational only and the chunk can still be
+ * processed, otherwise it sets rx_err to the cause.
+ */
+void oa_tc6_rx_eth_ready(struct oa_tc6 *tc6);
+int oa_tc6_process_exst(struct oa_tc6 *tc6);
+
+#endif /* _OA_TC6_FRAME_H */
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface port forwarding
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/debugfs.h>
+#include <linux/etherdevice.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/rcupdate.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include "oa_tc6_fwd.h"
+
+#define OA_TC6_FDB_SIZE		64	/* Power of 2 */
+#define OA_TC6_FDB_AGEING	(300 * HZ)
+
+/* Station learned from the source address of a frame received on the port */
+struct oa_tc6_fdb_entry {
+	u8 addr[ETH_ALEN];
+	unsigned long updated;
+};
+
+struct oa_tc6_fwd {
+	struct list_head node;
+	struct oa_tc6 *tc6;
+	struct oa_tc6 __rcu *peer;
+	struct device_node *peer_np;
+	bool enabled;
+	u64 forwarded;
+	u64 peer_busy;		/* Sent to the stack as the peer tx was busy */
+	u64 learned;
+	/* Only written by the tc6 task of the port, read by the one of the
+	 * peer. A torn entry can at worst send one frame through the stack.
+	 */
+	struct oa_tc6_fdb_entry fdb[OA_TC6_FDB_SIZE];
+};
+
+/* Pairs waiting for or linked to their peer */
+static LIST_HEAD(oa_tc6_fwd_list);
+static DEFINE_MUTEX(oa_tc6_fwd_lock);
+
+static struct oa_tc6_fdb_entry *oa_tc6_fdb_entry(struct oa_tc6_fwd *fwd,
+						 const u8 *addr)
+{
+	/* The last bytes are the most random ones of a MAC address */
+	return &fwd->fdb[(addr[3] ^ addr[4] ^ addr[5]) &
+			 (OA_TC6_FDB_SIZE - 1)];
+}
+
+static void oa_tc6_fdb_learn(struct oa_tc6_fwd *fwd, const u8 *addr)
+{
+	struct oa_tc6_fdb_entry *entry = oa_tc6_fdb_entry(fwd, addr);
+
+	if (!is_valid_ether_addr(addr))
+		return;
+
+	if (!ether_addr_equal(entry->addr, addr)) {
+		ether_addr_copy(entry->addr, addr);
+		fwd->learned++;
+	}
+	WRITE_ONCE(entry->updated, jiffies);
+}
+
+/* Returns the time the station was last seen behind the port, 0 if never
+ * or aged out.
+ */
+static unsigned long oa_tc6_fdb_lookup(struct oa_tc6_fwd *fwd, const u8 *addr)
+{
+	struct oa_tc6_fdb_entry *entry = oa_tc6_fdb_entry(fwd, addr);
+	unsigned long updated = READ_ONCE(entry->updated);
+
+	if (!updated || !ether_addr_equal(entry->addr, addr) ||
+	    time_after(jiffies, updated + OA_TC6_FDB_AGEING))
+		return 0;
+
+	return updated;
+}
+
+/* Called by the tc6 task with a complete frame in eth_rx_buf. Returns true
+ * if the frame was handed to the tx of the peer port, false if it has to go
+ * up to the stack: unknown, multicast and local destinations, stations
+ * behind this port and a busy peer.
+ */
+bool oa_tc6_fwd_rx(struct oa_tc6 *tc6)
+{
+	struct ethhdr *eth = (struct ethhdr *)tc6->eth_rx_buf;
+	struct oa_tc6_fwd *fwd = tc6->fwd;
+	struct netdev_queue *txq;
+	unsigned long peer_seen;
+	struct sk_buff *skb;
+	struct oa_tc6 *peer;
+	bool ret = false;
+
+	oa_tc6_fdb_learn(fwd, eth->h_source);
+
+	if (!READ_ONCE(fwd->enabled) || !is_unicast_ether_addr(eth->h_dest) ||
+	    ether_addr_equal(eth->h_dest, tc6->netdev->dev_addr))
+		return false;
+
+	rcu_read_lock();
+	peer = rcu_dereference(fwd->peer);
+	if (!peer || !netif_running(peer->netdev) ||
+	    ether_addr_equal(eth->h_dest, peer->netdev->dev_addr))
+		goto unlock;
+
+	/* A station which moved is forwarded by where it was seen last */
+	peer_seen = oa_tc6_fdb_lookup(peer->fwd, eth->h_dest);
+	if (!peer_seen ||
+	    time_after(oa_tc6_fdb_lookup(fwd, eth->h_dest), peer_seen))
+		goto unlock;
+
+	skb = netdev_alloc_skb(peer->netdev, tc6->rxd_bytes);
+	if (!skb)
+		goto unlock;
+	skb_put_data(skb, tc6->eth_rx_buf, tc6->rxd_bytes);
+
+	/* Lowest priority tx queue, like best effort frames of the stack,
+	 * and locked like them, netif_tx_lock_bh() would freeze the queue.
+	 */
+	txq = netdev_get_tx_queue(peer->netdev, 0);
+	__netif_tx_lock_bh(txq);
+	if (netif_xmit_frozen_or_stopped(txq) ||
+	    oa_tc6_send_eth_pkt(peer, skb) != NETDEV_TX_OK) {
+		__netif_tx_unlock_bh(txq);
+		dev_kfree_skb(skb);
+		fwd->peer_busy++;
+		goto unlock;
+	}
+	__netif_tx_unlock_bh(txq);
+
+	tc6->netdev->stats.rx_packets++;
+	tc6->netdev->stats.rx_bytes += tc6->rxd_bytes;
+	fwd->forwarded++;
+	ret = true;
+
+unlock:
+	rcu_read_unlock();
+	return ret;
+}
+
+static int oa_tc6_fwd_show(struct seq_file *s, void *unused)
+{
+	struct oa_tc6_fwd *fwd = s->private;
+	struct oa_tc6 *peer;
+
+	rcu_read_lock();
+	peer = rcu_dereference(fwd->peer);
+	seq_printf(s, "peer       %s\n", peer ? netdev_name(peer->netdev) :
+					       "(not probed)");
+	rcu_read_unlock();
+	seq_printf(s, "forwarded  %llu\n", fwd->forwarded);
+	seq_printf(s, "peer_busy  %llu\n", fwd->peer_busy);
+	seq_printf(s, "learned    %llu\n", fwd->learned);
+
+	for (int i = 0; i < OA_TC6_FDB_SIZE; i++) {
+		unsigned long updated = oa_tc6_fdb_lookup(fwd, fwd->fdb[i].addr);
+
+		if (updated)
+			seq_printf(s, "%pM %u ms\n", fwd->fdb[i].addr,
+				   jiffies_to_msecs(jiffies - updated));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(oa_tc6_fwd);
+
+/**
+ * oa_tc6_enable_forwarding - pair the device with another OA TC6 device
+ * @tc6: oa_tc6 struct.
+ * @peer_np: device tree node of the other device.
+ *
+ * The pair is linked once both devices are probed, either order.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int oa_tc6_enable_forwarding(struct oa_tc6 *tc6, struct device_node *peer_np)
+{
+	struct device_node *np = tc6->spi->dev.of_node;
+	struct oa_tc6_fwd *fwd;
+	struct oa_tc6_fwd *other;
+
+	if (!np || peer_np == np)
+		return -EINVAL;
+
+	fwd = kzalloc(sizeof(*fwd), GFP_KERNEL);
+	if (!fwd)
+		return -ENOMEM;
+
+	fwd->tc6 = tc6;
+	fwd->peer_np = of_node_get(peer_np);
+	fwd->enabled = true;
+	tc6->fwd = fwd;
+
+	mutex_lock(&oa_tc6_fwd_lock);
+	list_for_each_entry(other, &oa_tc6_fwd_list, node) {
+		if (other->tc6->spi->dev.of_node == peer_np &&
+		    other->peer_np == np) {
+			rcu_assign_pointer(other->peer, tc6);
+			rcu_assign_pointer(fwd->peer, other->tc6);
+			break;
+		}
+	}
+	list_add_tail(&fwd->node, &oa_tc6_fwd_list);
+	mutex_unlock(&oa_tc6_fwd_lock);
+
+	debugfs_create_bool("fwd_enable", 0600, tc6->debugfs, &fwd->enabled);
+	debugfs_create_file("fwd", 0400, tc6->debugfs, fwd, &oa_tc6_fwd_fops);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_enable_forwarding);
+
+void oa_tc6_fwd_deinit(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_fwd *fwd = tc6->fwd;
+	struct oa_tc6 *peer;
+
+	mutex_lock(&oa_tc6_fwd_lock);
+	list_del(&fwd->node);
+	peer = rcu_dereference_protected(fwd->peer,
+					 lockdep_is_held(&oa_tc6_fwd_lock));
+	if (peer)
+		RCU_INIT_POINTER(peer->fwd->peer, NULL);
+	RCU_INIT_POINTER(fwd->peer, NULL);
+	mutex_unlock(&oa_tc6_fwd_lock);
+
+	/* The tc6 task of the peer may still be forwarding a frame to us */
+	synchronize_rcu();
+
+	of_node_put(fwd->peer_np);
+	kfree(fwd);
+	tc6->fwd = NULL;
+}
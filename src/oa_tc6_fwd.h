@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface port forwarding
+ *
+ * Two MAC-PHYs can be paired so that a received frame for a station learned
+ * behind the other port is handed straight to the tx of that port instead
+ * of going through the network stack and a bridge.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_FWD_H
+#define _OA_TC6_FWD_H
+
+#include "oa_tc6.h"
+
+void oa_tc6_fwd_deinit(struct oa_tc6 *tc6);
+bool oa_tc6_fwd_rx(struct oa_tc6 *tc6);
+
+#endif /* _OA_TC6_FWD_H */
@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface error recovery
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/bitfield.h>
+#include <linux/delay.h>
+#include <linux/ethtool.h>
+#include <net/devlink.h>
+#include "oa_tc6_recovery.h"
+
+/* Framing errors in a row, without a good transfer in between, after which
+ * the MAC-PHY is reset.
+ */
+#define OA_TC6_ERR_STREAK_MAX	8
+
+#define OA_TC6_RESET_POLL_US	100
+#define OA_TC6_RESET_POLLS	50
+
+#define OA_TC6_REQUEST_TIMEOUT	msecs_to_jiffies(1000)
+
+static const char * const oa_tc6_err_names[OA_TC6_ERR_MAX] = {
+	[OA_TC6_ERR_NONE] = "none",
+	[OA_TC6_ERR_PARITY] = "parity",
+	[OA_TC6_ERR_OFFSET] = "offset",
+	[OA_TC6_ERR_STATUS] = "status",
+	[OA_TC6_ERR_LOFE] = "lofe",
+	[OA_TC6_ERR_HDRB] = "hdrb",
+	[OA_TC6_ERR_UNSYNC] = "unsync",
+	[OA_TC6_ERR_TX_TIMEOUT] = "tx_timeout",
+	[OA_TC6_ERR_REQUEST] = "request",
+};
+
+/* Reset without the reset complete interrupt, which is handled by the tc6
+ * task we are running in.
+ */
+static int oa_tc6_recovery_reset(struct oa_tc6 *tc6)
+{
+	u32 regval;
+	int ret;
+
+	ret = oa_tc6_reset_write(tc6);
+	if (ret)
+		return ret;
+
+	for (int i = 0; i < OA_TC6_RESET_POLLS; i++) {
+		usleep_range(OA_TC6_RESET_POLL_US, 2 * OA_TC6_RESET_POLL_US);
+		ret = oa_tc6_perform_ctrl(tc6, OA_TC6_STS0, &regval, 1, false,
+					  false);
+		if (ret || !(regval & RESETC))
+			continue;
+
+		regval = RESETC;
+		return oa_tc6_perform_ctrl(tc6, OA_TC6_STS0, &regval, 1, true,
+					   false);
+	}
+
+	return -ETIMEDOUT;
+}
+
+/**
+ * oa_tc6_reconfigure - reset the MAC-PHY and replay its configuration
+ * @tc6: oa_tc6 struct.
+ *
+ * From the tc6 task, or with the task parked.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_reconfigure(struct oa_tc6 *tc6)
+{
+	const struct oa_tc6_recovery_ops *ops = tc6->recovery_ops;
+	bool ctrl_prot = tc6->ctrl_prot;
+	struct sk_buff *skb;
+	u32 regval;
+	int ret;
+
+	/* The MAC-PHY comes out of reset with the protection off */
+	tc6->ctrl_prot = false;
+	ret = oa_tc6_recovery_reset(tc6);
+	if (ret)
+		goto out;
+
+	if (ops && ops->restore_early) {
+		ret = ops->restore_early(tc6->netdev);
+		if (ret)
+			goto out;
+	}
+
+	ret = oa_tc6_write_register(tc6, OA_TC6_IMASK0, &tc6->imask0, 1);
+	if (ret)
+		goto out;
+	ret = oa_tc6_write_register(tc6, OA_TC6_CONFIG0, &tc6->config0, 1);
+	if (ret)
+		goto out;
+	tc6->ctrl_prot = ctrl_prot;
+
+	ret = oa_tc6_read_register(tc6, OA_TC6_BUFSTS, &regval, 1);
+	if (ret)
+		goto out;
+	tc6->txc = FIELD_GET(TXC, regval);
+	tc6->rca = FIELD_GET(RCA, regval);
+
+	/* Whatever was in flight is lost */
+	tc6->rxd_bytes = 0;
+	tc6->rx_eth_started = false;
+	skb = xchg(&tc6->tx_ts_skb, NULL);
+	dev_kfree_skb_any(skb);
+
+	if (ops && ops->restore)
+		ret = ops->restore(tc6->netdev);
+
+out:
+	tc6->ctrl_prot = ctrl_prot;
+	return ret;
+}
+
+/* Called by the tc6 task. The frame in flight is restarted by the caller. */
+static int oa_tc6_recover(struct oa_tc6 *tc6, enum oa_tc6_err cause)
+{
+	struct oa_tc6_err_stats *stats = &tc6->err_stats;
+	u64 start_ns = ktime_get_ns();
+	u64 time_ns;
+	int ret;
+
+	netdev_warn(tc6->netdev, "Resetting the MAC-PHY after %s error\n",
+		    oa_tc6_err_names[cause]);
+
+	ret = oa_tc6_reconfigure(tc6);
+	tc6->err_streak = 0;
+	time_ns = ktime_get_ns() - start_ns;
+	if (ret) {
+		stats->recovery_failures++;
+		netdev_err(tc6->netdev, "MAC-PHY recovery failed (%d)\n", ret);
+		return ret;
+	}
+
+	stats->recoveries++;
+	stats->recovery_last_ns = time_ns;
+	if (time_ns > stats->recovery_max_ns)
+		stats->recovery_max_ns = time_ns;
+	netdev_info(tc6->netdev, "MAC-PHY recovered in %llu us\n",
+		    div_u64(time_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+
+static int oa_tc6_health_recover(struct devlink_health_reporter *reporter,
+				 void *priv_ctx, struct netlink_ext_ack *extack)
+{
+	struct oa_tc6 *tc6 = devlink_health_reporter_priv(reporter);
+	u64 failures = tc6->err_stats.recovery_failures;
+
+	/* Reported by the tc6 task itself */
+	if (priv_ctx)
+		return oa_tc6_recover(tc6, *(enum oa_tc6_err *)priv_ctx);
+
+	reinit_completion(&tc6->recovery_done);
+	WRITE_ONCE(tc6->recovery_req, OA_TC6_ERR_REQUEST);
+	wake_up_interruptible(&tc6->tc6_wq);
+	if (!wait_for_completion_timeout(&tc6->recovery_done,
+					 OA_TC6_REQUEST_TIMEOUT))
+		return -ETIMEDOUT;
+
+	return tc6->err_stats.recovery_failures != failures ? -EIO : 0;
+}
+
+static int oa_tc6_health_diagnose(struct devlink_health_reporter *reporter,
+				  struct devlink_fmsg *fmsg,
+				  struct netlink_ext_ack *extack)
+{
+	struct oa_tc6 *tc6 = devlink_health_reporter_priv(reporter);
+	struct oa_tc6_err_stats *stats = &tc6->err_stats;
+	int ret;
+
+	ret = devlink_fmsg_u64_pair_put(fmsg, "recoveries", stats->recoveries);
+	if (ret)
+		return ret;
+	ret = devlink_fmsg_u64_pair_put(fmsg, "recovery_failures",
+					stats->recovery_failures);
+	if (ret)
+		return ret;
+	ret = devlink_fmsg_u64_pair_put(fmsg, "recovery_last_ns",
+					stats->recovery_last_ns);
+	if (ret)
+		return ret;
+	ret = devlink_fmsg_u64_pair_put(fmsg, "recovery_max_ns",
+					stats->recovery_max_ns);
+	if (ret)
+		return ret;
+
+	for (int i = OA_TC6_ERR_NONE + 1; i < OA_TC6_ERR_MAX; i++) {
+		ret = devlink_fmsg_u64_pair_put(fmsg, oa_tc6_err_names[i],
+						stats->errors[i]);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct devlink_health_reporter_ops oa_tc6_health_ops = {
+	.name = "mac-phy",
+	.recover = oa_tc6_health_recover,
+	.diagnose = oa_tc6_health_diagnose,
+};
+
+static const struct devlink_ops oa_tc6_devlink_ops = {
+};
+
+static int oa_tc6_recovery_report(struct oa_tc6 *tc6, enum oa_tc6_err cause)
+{
+	if (!tc6->health)
+		return oa_tc6_recover(tc6, cause);
+
+	/* Recovers through oa_tc6_health_recover() unless turned off */
+	return devlink_health_report(tc6->health, oa_tc6_err_names[cause],
+				     &cause);
+}
+
+/**
+ * oa_tc6_recovery_error - handle an error of oa_tc6_process_rx_chunks()
+ * @tc6: oa_tc6 struct.
+ *
+ * Called by the tc6 task.
+ *
+ * Return: true if the MAC-PHY was reset and the tx frame in flight has to
+ * be restarted.
+ */
+bool oa_tc6_recovery_error(struct oa_tc6 *tc6)
+{
+	enum oa_tc6_err cause = tc6->rx_err;
+
+	tc6->rx_err = OA_TC6_ERR_NONE;
+	tc6->err_stats.errors[cause]++;
+
+	/* Framing errors cost the frames in flight only, unless they keep
+	 * coming. A MAC-PHY which lost its configuration doesn't transfer
+	 * any data until it is configured again.
+	 */
+	if (cause != OA_TC6_ERR_UNSYNC &&
+	    ++tc6->err_streak < OA_TC6_ERR_STREAK_MAX)
+		return false;
+
+	oa_tc6_recovery_report(tc6, cause);
+
+	return true;
+}
+
+/**
+ * oa_tc6_recovery_run_request - run a recovery requested from elsewhere
+ * @tc6: oa_tc6 struct.
+ *
+ * Called by the tc6 task when recovery_req is set.
+ *
+ * Return: true if the tx frame in flight has to be restarted.
+ */
+bool oa_tc6_recovery_run_request(struct oa_tc6 *tc6)
+{
+	enum oa_tc6_err cause = xchg(&tc6->recovery_req, OA_TC6_ERR_NONE);
+
+	if (cause == OA_TC6_ERR_NONE)
+		return false;
+
+	tc6->err_stats.errors[cause]++;
+	if (cause == OA_TC6_ERR_REQUEST)
+		oa_tc6_recover(tc6, cause);
+	else
+		oa_tc6_recovery_report(tc6, cause);
+	complete_all(&tc6->recovery_done);
+
+	return true;
+}
+
+/**
+ * oa_tc6_request_recovery - reset the MAC-PHY and restore its configuration
+ * @tc6: oa_tc6 struct.
+ *
+ * For a stuck tx, from ndo_tx_timeout. The recovery is done asynchronously
+ * by the tc6 task.
+ */
+void oa_tc6_request_recovery(struct oa_tc6 *tc6)
+{
+	cmpxchg(&tc6->recovery_req, OA_TC6_ERR_NONE, OA_TC6_ERR_TX_TIMEOUT);
+	wake_up_interruptible(&tc6->tc6_wq);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_request_recovery);
+
+/**
+ * oa_tc6_set_recovery_ops - MAC specific part of the recovery
+ * @tc6: oa_tc6 struct.
+ * @ops: called to restore the MAC state after a reset.
+ */
+void oa_tc6_set_recovery_ops(struct oa_tc6 *tc6,
+			     const struct oa_tc6_recovery_ops *ops)
+{
+	tc6->recovery_ops = ops;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_recovery_ops);
+
+/* Follow the err_<cause> counters */
+static const char oa_tc6_recovery_strings[][ETH_GSTRING_LEN] = {
+	"recoveries",
+	"recovery_failures",
+	"recovery_last_ns",
+	"recovery_max_ns",
+};
+
+int oa_tc6_recovery_get_sset_count(void)
+{
+	return OA_TC6_ERR_MAX - 1 + ARRAY_SIZE(oa_tc6_recovery_strings);
+}
+
+void oa_tc6_recovery_get_strings(u8 *data)
+{
+	for (int i = OA_TC6_ERR_NONE + 1; i < OA_TC6_ERR_MAX; i++) {
+		snprintf((char *)data, ETH_GSTRING_LEN, "err_%s",
+			 oa_tc6_err_names[i]);
+		data += ETH_GSTRING_LEN;
+	}
+	memcpy(data, oa_tc6_recovery_strings, sizeof(oa_tc6_recovery_strings));
+}
+
+void oa_tc6_recovery_get_stats(struct oa_tc6 *tc6, u64 *data)
+{
+	struct oa_tc6_err_stats *stats = &tc6->err_stats;
+
+	for (int i = OA_TC6_ERR_NONE + 1; i < OA_TC6_ERR_MAX; i++)
+		*data++ = stats->errors[i];
+	*data++ = stats->recoveries;
+	*data++ = stats->recovery_failures;
+	*data++ = stats->recovery_last_ns;
+	*data++ = stats->recovery_max_ns;
+}
+
+int oa_tc6_recovery_init(struct oa_tc6 *tc6)
+{
+	struct devlink_health_reporter *health;
+	int ret;
+
+	init_completion(&tc6->recovery_done);
+
+	tc6->devlink = devlink_alloc(&oa_tc6_devlink_ops, sizeof(tc6),
+				     &tc6->spi->dev);
+	if (!tc6->devlink)
+		return -ENOMEM;
+
+	/* The budgets of the data transfers, see oa_tc6.c */
+	ret = oa_tc6_devlink_params_register(tc6);
+	if (ret) {
+		devlink_free(tc6->devlink);
+		return ret;
+	}
+
+	/* Without the reporter the recovery still runs, just unreported */
+	health = devlink_health_reporter_create(tc6->devlink,
+						&oa_tc6_health_ops, 0, tc6);
+	if (IS_ERR(health))
+		dev_warn(&tc6->spi->dev, "No devlink health reporter (%ld)\n",
+			 PTR_ERR(health));
+	else
+		tc6->health = health;
+	devlink_register(tc6->devlink);
+
+	return 0;
+}
+
+void oa_tc6_recovery_deinit(struct oa_tc6 *tc6)
+{
+	devlink_unregister(tc6->devlink);
+	if (tc6->health)
+		devlink_health_reporter_destroy(tc6->health);
+	oa_tc6_devlink_params_unregister(tc6);
+	devlink_free(tc6->devlink);
+}
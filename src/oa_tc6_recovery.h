@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface error recovery
+ *
+ * Errors seen in the data transfer are classified by cause. Framing errors
+ * only cost the frames in flight, unless they keep coming, while a MAC-PHY
+ * which lost its configuration is reset and the cached configuration is
+ * replayed without unloading the driver. Recoveries are reported through a
+ * devlink health reporter.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_RECOVERY_H
+#define _OA_TC6_RECOVERY_H
+
+#include "oa_tc6.h"
+
+/* In oa_tc6.c */
+int oa_tc6_perform_ctrl(struct oa_tc6 *tc6, u32 addr, u32 val[], u8 len,
+			bool wnr, bool ctrl_prot);
+int oa_tc6_reset_write(struct oa_tc6 *tc6);
+int oa_tc6_devlink_params_register(struct oa_tc6 *tc6);
+void oa_tc6_devlink_params_unregister(struct oa_tc6 *tc6);
+
+int oa_tc6_recovery_init(struct oa_tc6 *tc6);
+void oa_tc6_recovery_deinit(struct oa_tc6 *tc6);
+int oa_tc6_reconfigure(struct oa_tc6 *tc6);
+bool oa_tc6_recovery_error(struct oa_tc6 *tc6);
+bool oa_tc6_recovery_run_request(struct oa_tc6 *tc6);
+int oa_tc6_recovery_get_sset_count(void);
+void oa_tc6_recovery_get_strings(u8 *data);
+void oa_tc6_recovery_get_stats(struct oa_tc6 *tc6, u64 *data);
+
+/* A transfer went through, errors from now on are a new streak */
+static inline void oa_tc6_recovery_ok(struct oa_tc6 *tc6)
+{
+	tc6->err_streak = 0;
+}
+
+#endif /* _OA_TC6_RECOVERY_H */
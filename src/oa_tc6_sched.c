@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface bus scheduler
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include "oa_tc6_sched.h"
+
+/* One per SPI controller with at least one OA TC6 device on it */
+struct oa_tc6_sched {
+	struct list_head node;
+	struct spi_controller *ctlr;
+	/* Protects owner, members and the waiting flags of the members */
+	spinlock_t lock;
+	wait_queue_head_t wq;
+	/* Least recently granted member first */
+	struct list_head members;
+	struct oa_tc6 *owner;
+	u8 count;
+	/* Indexes in use, the lowest free one goes to the next member */
+	DECLARE_BITMAP(indexes, U8_MAX + 1);
+};
+
+static LIST_HEAD(oa_tc6_scheds);
+static DEFINE_MUTEX(oa_tc6_scheds_lock);
+
+static unsigned int sched_quantum = 2048;
+module_param(sched_quantum, uint, 0644);
+MODULE_PARM_DESC(sched_quantum,
+		 "Bytes per unit of weight a MAC-PHY may transfer in one turn on a shared SPI bus (1536 to 65536)");
+
+/* Bytes the device may transfer in one turn */
+static s32 oa_tc6_sched_quantum(struct oa_tc6 *tc6)
+{
+	return clamp_t(u32, tc6->sched_weight, 1, OA_TC6_SCHED_MAX_WEIGHT) *
+	       clamp_t(u32, READ_ONCE(sched_quantum), MAX_ETH_LEN, SZ_64K);
+}
+
+static void oa_tc6_sched_grant_next(struct oa_tc6_sched *sched)
+{
+	struct oa_tc6 *tc6;
+
+	lockdep_assert_held(&sched->lock);
+
+	list_for_each_entry(tc6, &sched->members, sched_node) {
+		if (!tc6->sched_waiting)
+			continue;
+		tc6->sched_waiting = false;
+		tc6->sched_deficit += oa_tc6_sched_quantum(tc6);
+		list_move_tail(&tc6->sched_node, &sched->members);
+		sched->owner = tc6;
+		wake_up(&sched->wq);
+		return;
+	}
+}
+
+static bool oa_tc6_sched_others_waiting(struct oa_tc6_sched *sched,
+					struct oa_tc6 *tc6)
+{
+	struct oa_tc6 *member;
+
+	list_for_each_entry(member, &sched->members, sched_node)
+		if (member != tc6 && member->sched_waiting)
+			return true;
+
+	return false;
+}
+
+static bool oa_tc6_sched_granted(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_sched *sched = tc6->sched;
+	bool granted;
+
+	spin_lock(&sched->lock);
+	if (!sched->owner)
+		oa_tc6_sched_grant_next(sched);
+	granted = sched->owner == tc6;
+	spin_unlock(&sched->lock);
+
+	return granted;
+}
+
+/* Wait for the turn of the device on the bus. Only the tc6 task takes part
+ * in the scheduling, register accesses from other contexts go straight to
+ * the SPI core.
+ */
+void oa_tc6_sched_acquire(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_sched *sched = tc6->sched;
+	u64 start_ns;
+	u64 wait_ns;
+
+	if (READ_ONCE(sched->owner) == tc6)
+		return;
+
+	start_ns = ktime_get_ns();
+	spin_lock(&sched->lock);
+	tc6->sched_waiting = true;
+	spin_unlock(&sched->lock);
+
+	wait_event(sched->wq, oa_tc6_sched_granted(tc6));
+
+	wait_ns = ktime_get_ns() - start_ns;
+	tc6->bus_stats.sched_grants++;
+	tc6->bus_stats.sched_wait_ns += wait_ns;
+	if (wait_ns > tc6->bus_stats.sched_max_wait_ns)
+		tc6->bus_stats.sched_max_wait_ns = wait_ns;
+}
+
+/* Give up the bus. A device going idle loses its remaining deficit as it
+ * has nothing to spend it on.
+ */
+void oa_tc6_sched_release(struct oa_tc6 *tc6, bool idle)
+{
+	struct oa_tc6_sched *sched = tc6->sched;
+
+	spin_lock(&sched->lock);
+	if (sched->owner == tc6) {
+		sched->owner = NULL;
+		if (idle)
+			tc6->sched_deficit = 0;
+		oa_tc6_sched_grant_next(sched);
+	}
+	spin_unlock(&sched->lock);
+}
+
+/* Called between transfers while the device still has work. Once the
+ * deficit is spent the bus goes to the next waiting device, if any.
+ */
+void oa_tc6_sched_yield(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_sched *sched = tc6->sched;
+
+	if (tc6->sched_deficit > 0)
+		return;
+
+	spin_lock(&sched->lock);
+	if (sched->owner == tc6) {
+		if (oa_tc6_sched_others_waiting(sched, tc6)) {
+			sched->owner = NULL;
+			oa_tc6_sched_grant_next(sched);
+		} else {
+			tc6->sched_deficit += oa_tc6_sched_quantum(tc6);
+		}
+	}
+	spin_unlock(&sched->lock);
+}
+
+int oa_tc6_sched_join(struct oa_tc6 *tc6)
+{
+	struct spi_controller *ctlr = tc6->spi->controller;
+	struct oa_tc6_sched *sched;
+
+	mutex_lock(&oa_tc6_scheds_lock);
+	list_for_each_entry(sched, &oa_tc6_scheds, node)
+		if (sched->ctlr == ctlr)
+			goto found;
+
+	sched = kzalloc(sizeof(*sched), GFP_KERNEL);
+	if (!sched) {
+		mutex_unlock(&oa_tc6_scheds_lock);
+		return -ENOMEM;
+	}
+	sched->ctlr = ctlr;
+	spin_lock_init(&sched->lock);
+	init_waitqueue_head(&sched->wq);
+	INIT_LIST_HEAD(&sched->members);
+	list_add_tail(&sched->node, &oa_tc6_scheds);
+
+found:
+	tc6->sched = sched;
+	if (!tc6->sched_weight)
+		tc6->sched_weight = 1;
+	spin_lock(&sched->lock);
+	list_add_tail(&tc6->sched_node, &sched->members);
+	tc6->sched_index = find_first_zero_bit(sched->indexes, U8_MAX + 1);
+	__set_bit(tc6->sched_index, sched->indexes);
+	sched->count++;
+	spin_unlock(&sched->lock);
+	mutex_unlock(&oa_tc6_scheds_lock);
+
+	return 0;
+}
+
+void oa_tc6_sched_leave(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_sched *sched = tc6->sched;
+
+	mutex_lock(&oa_tc6_scheds_lock);
+	spin_lock(&sched->lock);
+	list_del(&tc6->sched_node);
+	tc6->sched_waiting = false;
+	if (sched->owner == tc6) {
+		sched->owner = NULL;
+		oa_tc6_sched_grant_next(sched);
+	}
+	__clear_bit(tc6->sched_index, sched->indexes);
+	sched->count--;
+	spin_unlock(&sched->lock);
+
+	if (!sched->count) {
+		list_del(&sched->node);
+		kfree(sched);
+	}
+	mutex_unlock(&oa_tc6_scheds_lock);
+	tc6->sched = NULL;
+}
+
+void oa_tc6_sched_debugfs_init(struct oa_tc6 *tc6, struct dentry *dir)
+{
+	debugfs_create_u32("sched_weight", 0600, dir, &tc6->sched_weight);
+}
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface bus scheduler
+ *
+ * MAC-PHYs sharing one SPI controller take turns on the bus in deficit round
+ * robin order. A device holds the bus for a batch of transfers worth its
+ * weight in bytes before the next waiting device is granted the bus.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_SCHED_H
+#define _OA_TC6_SCHED_H
+
+#include "oa_tc6.h"
+
+#define OA_TC6_SCHED_MAX_WEIGHT	16
+
+int oa_tc6_sched_join(struct oa_tc6 *tc6);
+void oa_tc6_sched_leave(struct oa_tc6 *tc6);
+void oa_tc6_sched_acquire(struct oa_tc6 *tc6);
+void oa_tc6_sched_release(struct oa_tc6 *tc6, bool idle);
+void oa_tc6_sched_yield(struct oa_tc6 *tc6);
+void oa_tc6_sched_debugfs_init(struct oa_tc6 *tc6, struct dentry *dir);
+
+/* Charge a transfer of the tc6 task against the deficit of the device */
+static inline void oa_tc6_sched_charge(struct oa_tc6 *tc6, u16 len)
+{
+	tc6->sched_deficit -= len;
+}
+
+#endif /* _OA_TC6_SCHED_H */
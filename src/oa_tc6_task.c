@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface task placement
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/cpumask.h>
+#include <linux/kobject.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/sched/isolation.h>
+#include <linux/slab.h>
+#include <linux/sysfs.h>
+#include <uapi/linux/sched/types.h>
+#include "oa_tc6_task.h"
+
+static char *task_policy = "fifo";
+module_param(task_policy, charp, 0444);
+MODULE_PARM_DESC(task_policy,
+		 "Scheduling policy of the SPI tasks: fifo, rr or other (default fifo)");
+
+static unsigned int task_priority = MAX_RT_PRIO / 2;
+module_param(task_priority, uint, 0444);
+MODULE_PARM_DESC(task_priority,
+		 "Real-time priority of the SPI tasks, 1 to 99 (default 50)");
+
+static bool task_isolated;
+module_param(task_isolated, bool, 0444);
+MODULE_PARM_DESC(task_isolated,
+		 "Place the SPI tasks on the CPUs isolated with isolcpus= instead of any CPU");
+
+struct oa_tc6_task {
+	struct kobject kobj;
+	struct oa_tc6 *tc6;
+	cpumask_var_t cpus;
+	u8 policy;
+	u8 priority;
+};
+
+/* Serializes the sysfs writes of all devices */
+static DEFINE_MUTEX(oa_tc6_task_lock);
+
+static const char * const oa_tc6_policy_names[] = {
+	[SCHED_NORMAL] = "other",
+	[SCHED_FIFO] = "fifo",
+	[SCHED_RR] = "rr",
+};
+
+static int oa_tc6_task_apply(struct oa_tc6_task *task)
+{
+	struct sched_attr attr = {
+		.size = sizeof(attr),
+		.sched_policy = task->policy,
+	};
+	int ret;
+
+	if (task->policy != SCHED_NORMAL)
+		attr.sched_priority = task->priority;
+
+	ret = sched_setattr_nocheck(task->tc6->tc6_task, &attr);
+	if (ret)
+		return ret;
+
+	return set_cpus_allowed_ptr(task->tc6->tc6_task, task->cpus);
+}
+
+/* Spread the tasks of the devices sharing a controller over the CPUs so
+ * that they don't preempt each other, over the isolated CPUs only if asked
+ * for. Isolated CPUs keep the application load and the scheduler balancing
+ * away from the task, and with nohz_full also the tick.
+ */
+static void oa_tc6_task_default_cpus(struct oa_tc6_task *task)
+{
+	struct oa_tc6 *tc6 = task->tc6;
+	unsigned int cpu;
+	unsigned int n;
+
+	if (task_isolated) {
+		cpumask_andnot(task->cpus, cpu_online_mask,
+			       housekeeping_cpumask(HK_TYPE_DOMAIN));
+		if (!cpumask_empty(task->cpus)) {
+			n = tc6->sched_index % cpumask_weight(task->cpus);
+			for_each_cpu(cpu, task->cpus)
+				if (!n--)
+					break;
+			cpumask_copy(task->cpus, cpumask_of(cpu));
+			return;
+		}
+		dev_warn(&tc6->spi->dev, "No isolated CPU for the SPI task\n");
+	}
+
+	cpu = cpumask_local_spread(tc6->sched_index,
+				   dev_to_node(&tc6->spi->dev));
+	cpumask_copy(task->cpus, cpumask_of(cpu));
+}
+
+struct oa_tc6_task_attr {
+	struct attribute attr;
+	ssize_t (*show)(struct oa_tc6_task *task, char *buf);
+	ssize_t (*store)(struct oa_tc6_task *task, const char *buf,
+			 size_t count);
+};
+
+static ssize_t task_policy_show(struct oa_tc6_task *task, char *buf)
+{
+	return sysfs_emit(buf, "%s\n", oa_tc6_policy_names[task->policy]);
+}
+
+static ssize_t task_policy_store(struct oa_tc6_task *task, const char *buf,
+				 size_t count)
+{
+	u8 old = task->policy;
+	int policy;
+	int ret;
+
+	policy = sysfs_match_string(oa_tc6_policy_names, buf);
+	if (policy < 0)
+		return policy;
+
+	task->policy = policy;
+	ret = oa_tc6_task_apply(task);
+	if (ret) {
+		task->policy = old;
+		oa_tc6_task_apply(task);
+		return ret;
+	}
+
+	return count;
+}
+
+static ssize_t task_priority_show(struct oa_tc6_task *task, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", task->priority);
+}
+
+static ssize_t task_priority_store(struct oa_tc6_task *task, const char *buf,
+				   size_t count)
+{
+	u8 old = task->priority;
+	u8 priority;
+	int ret;
+
+	ret = kstrtou8(buf, 0, &priority);
+	if (ret)
+		return ret;
+	if (!priority || priority >= MAX_RT_PRIO)
+		return -EINVAL;
+
+	task->priority = priority;
+	ret = oa_tc6_task_apply(task);
+	if (ret) {
+		task->priority = old;
+		oa_tc6_task_apply(task);
+		return ret;
+	}
+
+	return count;
+}
+
+static ssize_t task_cpus_show(struct oa_tc6_task *task, char *buf)
+{
+	return sysfs_emit(buf, "%*pbl\n", cpumask_pr_args(task->cpus));
+}
+
+static ssize_t task_cpus_store(struct oa_tc6_task *task, const char *buf,
+			       size_t count)
+{
+	cpumask_var_t cpus;
+	int ret;
+
+	if (!alloc_cpumask_var(&cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpulist_parse(buf, cpus);
+	if (ret)
+		goto out;
+	if (!cpumask_intersects(cpus, cpu_online_mask)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = set_cpus_allowed_ptr(task->tc6->tc6_task, cpus);
+	if (!ret)
+		cpumask_copy(task->cpus, cpus);
+out:
+	free_cpumask_var(cpus);
+	return ret ? ret : count;
+}
+
+#define OA_TC6_TASK_ATTR(_name) \
+	static struct oa_tc6_task_attr oa_tc6_task_attr_##_name = \
+		__ATTR(_name, 0644, _name##_show, _name##_store)
+
+OA_TC6_TASK_ATTR(task_policy);
+OA_TC6_TASK_ATTR(task_priority);
+OA_TC6_TASK_ATTR(task_cpus);
+
+static struct attribute *oa_tc6_task_attrs[] = {
+	&oa_tc6_task_attr_task_policy.attr,
+	&oa_tc6_task_attr_task_priority.attr,
+	&oa_tc6_task_attr_task_cpus.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(oa_tc6_task);
+
+static ssize_t oa_tc6_task_attr_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct oa_tc6_task *task = container_of(kobj, struct oa_tc6_task, kobj);
+	struct oa_tc6_task_attr *task_attr;
+	ssize_t ret;
+
+	task_attr = container_of(attr, struct oa_tc6_task_attr, attr);
+	mutex_lock(&oa_tc6_task_lock);
+	ret = task_attr->show(task, buf);
+	mutex_unlock(&oa_tc6_task_lock);
+
+	return ret;
+}
+
+static ssize_t oa_tc6_task_attr_store(struct kobject *kobj,
+				      struct attribute *attr, const char *buf,
+				      size_t count)
+{
+	struct oa_tc6_task *task = container_of(kobj, struct oa_tc6_task, kobj);
+	struct oa_tc6_task_attr *task_attr;
+	ssize_t ret;
+
+	task_attr = container_of(attr, struct oa_tc6_task_attr, attr);
+	mutex_lock(&oa_tc6_task_lock);
+	ret = task_attr->store(task, buf, count);
+	mutex_unlock(&oa_tc6_task_lock);
+
+	return ret;
+}
+
+static const struct sysfs_ops oa_tc6_task_sysfs_ops = {
+	.show = oa_tc6_task_attr_show,
+	.store = oa_tc6_task_attr_store,
+};
+
+static void oa_tc6_task_release(struct kobject *kobj)
+{
+	struct oa_tc6_task *task = container_of(kobj, struct oa_tc6_task, kobj);
+
+	free_cpumask_var(task->cpus);
+	kfree(task);
+}
+
+static const struct kobj_type oa_tc6_task_ktype = {
+	.release = oa_tc6_task_release,
+	.sysfs_ops = &oa_tc6_task_sysfs_ops,
+	.default_groups = oa_tc6_task_groups,
+};
+
+int oa_tc6_task_init(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_task *task;
+	int policy;
+	int ret;
+
+	task = kzalloc(sizeof(*task), GFP_KERNEL);
+	if (!task)
+		return -ENOMEM;
+
+	if (!zalloc_cpumask_var(&task->cpus, GFP_KERNEL)) {
+		kfree(task);
+		return -ENOMEM;
+	}
+
+	task->tc6 = tc6;
+	policy = sysfs_match_string(oa_tc6_policy_names, task_policy);
+	if (policy < 0) {
+		dev_warn(&tc6->spi->dev, "Unknown task_policy %s, using fifo\n",
+			 task_policy);
+		policy = SCHED_FIFO;
+	}
+	task->policy = policy;
+	task->priority = clamp_t(u32, task_priority, 1, MAX_RT_PRIO - 1);
+	oa_tc6_task_default_cpus(task);
+
+	/* The task still runs with the default policy if this fails */
+	ret = oa_tc6_task_apply(task);
+	if (ret)
+		dev_warn(&tc6->spi->dev, "Failed to place the SPI task (%d)\n",
+			 ret);
+
+	ret = kobject_init_and_add(&task->kobj, &oa_tc6_task_ktype,
+				   &tc6->spi->dev.kobj, "oa_tc6");
+	if (ret) {
+		kobject_put(&task->kobj);
+		return ret;
+	}
+	tc6->task = task;
+
+	return 0;
+}
+
+void oa_tc6_task_deinit(struct oa_tc6 *tc6)
+{
+	kobject_put(&tc6->task->kobj);
+	tc6->task = NULL;
+}
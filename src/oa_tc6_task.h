@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface task placement
+ *
+ * Scheduling policy, priority and CPUs of the tc6 task of each device. The
+ * defaults come from module parameters and can be changed per device in
+ * the oa_tc6 directory of the SPI device in sysfs.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_TASK_H
+#define _OA_TC6_TASK_H
+
+#include "oa_tc6.h"
+
+int oa_tc6_task_init(struct oa_tc6 *tc6);
+void oa_tc6_task_deinit(struct oa_tc6 *tc6);
+
+#endif /* _OA_TC6_TASK_H */
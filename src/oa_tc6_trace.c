@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface SPI trace
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#include <linux/bitfield.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include "oa_tc6.h"
+#include "oa_tc6_trace.h"
+
+#define OA_TC6_TRACE_DEFAULT_SIZE	SZ_4M
+#define OA_TC6_TRACE_MIN_SIZE		SZ_64K
+#define OA_TC6_TRACE_MAX_SIZE		SZ_64M
+#define OA_TC6_TRACE_HDR_SIZE		sizeof(struct oa_tc6_trace_rec)
+
+struct oa_tc6_trace {
+	/* Protects the ring. Records come from the tc6 task as well as from
+	 * the control register accesses of the other contexts.
+	 */
+	spinlock_t lock;
+	/* Serializes buffer (re)allocation against read and mmap */
+	struct mutex buf_lock;
+	void *buf;
+	struct oa_tc6_trace_info *info;
+	u8 *data;
+	u32 size;
+};
+
+static void oa_tc6_trace_drop_oldest(struct oa_tc6_trace *trace)
+{
+	struct oa_tc6_trace_info *info = trace->info;
+	struct oa_tc6_trace_rec *rec;
+	u32 size;
+
+	if (info->size - info->tail < OA_TC6_TRACE_HDR_SIZE) {
+		size = info->size - info->tail;
+	} else {
+		rec = (struct oa_tc6_trace_rec *)&trace->data[info->tail];
+		size = rec->size;
+		if (rec->type != OA_TC6_TRACE_PAD)
+			info->overwritten++;
+	}
+
+	info->tail += size;
+	if (info->tail == info->size)
+		info->tail = 0;
+	info->used -= size;
+}
+
+static void *oa_tc6_trace_reserve(struct oa_tc6_trace *trace, u32 need)
+{
+	struct oa_tc6_trace_info *info = trace->info;
+	u32 rem = info->size - info->head;
+	struct oa_tc6_trace_rec *pad;
+	void *rec;
+
+	if (need > rem) {
+		/* Not enough room up to the end of the ring, fill it and wrap
+		 * around.
+		 */
+		while (info->size - info->used < rem)
+			oa_tc6_trace_drop_oldest(trace);
+		if (rem >= OA_TC6_TRACE_HDR_SIZE) {
+			pad = (struct oa_tc6_trace_rec *)&trace->data[info->head];
+			memset(pad, 0, sizeof(*pad));
+			pad->size = rem;
+			pad->type = OA_TC6_TRACE_PAD;
+		}
+		info->used += rem;
+		info->head = 0;
+	}
+
+	while (info->size - info->used < need)
+		oa_tc6_trace_drop_oldest(trace);
+
+	rec = &trace->data[info->head];
+	info->head += need;
+	if (info->head == info->size)
+		info->head = 0;
+	info->used += need;
+
+	return rec;
+}
+
+void oa_tc6_trace_record(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u16 len,
+			 u64 ts_ns, u32 duration_ns)
+{
+	struct oa_tc6_trace *trace = tc6->trace;
+	struct oa_tc6_trace_rec *rec;
+	unsigned long flags;
+	u32 hdr;
+
+	spin_lock_irqsave(&trace->lock, flags);
+	if (!trace->info)
+		goto unlock;
+
+	hdr = be32_to_cpu(*(u32 *)&ptx[0]);
+	rec = oa_tc6_trace_reserve(trace, OA_TC6_TRACE_REC_SIZE(len));
+	rec->ts_ns = ts_ns;
+	rec->duration_ns = duration_ns;
+	rec->seq = trace->info->records++;
+	rec->size = OA_TC6_TRACE_REC_SIZE(len);
+	rec->len = len;
+	rec->type = FIELD_GET(DATA_HDR_DNC, hdr) ? OA_TC6_TRACE_DATA :
+						   OA_TC6_TRACE_CTRL;
+	rec->cps = tc6->cps;
+	memcpy(rec + 1, ptx, len);
+	memcpy((u8 *)(rec + 1) + len, prx, len);
+
+unlock:
+	spin_unlock_irqrestore(&trace->lock, flags);
+}
+
+static int oa_tc6_trace_start(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_trace *trace = tc6->trace;
+	struct oa_tc6_trace_info *info;
+	unsigned long flags;
+	void *old = NULL;
+	void *buf;
+	u32 size;
+
+	size = clamp_t(u32, PAGE_ALIGN(trace->size), OA_TC6_TRACE_MIN_SIZE,
+		       OA_TC6_TRACE_MAX_SIZE);
+	trace->size = size;
+
+	if (!trace->buf || trace->info->size != size) {
+		/* vmalloc_user() so that the buffer can be mmap'ed */
+		buf = vmalloc_user(OA_TC6_TRACE_DATA_OFFSET + size);
+		if (!buf)
+			return -ENOMEM;
+
+		spin_lock_irqsave(&trace->lock, flags);
+		old = trace->buf;
+		trace->buf = buf;
+		trace->info = buf;
+		trace->data = buf + OA_TC6_TRACE_DATA_OFFSET;
+		spin_unlock_irqrestore(&trace->lock, flags);
+		/* Pages still mapped by userspace stay alive until unmapped */
+		vfree(old);
+	}
+
+	spin_lock_irqsave(&trace->lock, flags);
+	info = trace->info;
+	memset(info, 0, sizeof(*info));
+	info->magic = OA_TC6_TRACE_MAGIC;
+	info->version = OA_TC6_TRACE_VERSION;
+	info->data_offset = OA_TC6_TRACE_DATA_OFFSET;
+	info->size = size;
+	spin_unlock_irqrestore(&trace->lock, flags);
+
+	WRITE_ONCE(tc6->trace_enabled, true);
+
+	return 0;
+}
+
+static ssize_t oa_tc6_trace_enable_read(struct file *file, char __user *ubuf,
+					size_t count, loff_t *ppos)
+{
+	struct oa_tc6 *tc6 = file->private_data;
+	char buf[3];
+
+	buf[0] = READ_ONCE(tc6->trace_enabled) ? 'Y' : 'N';
+	buf[1] = '\n';
+	buf[2] = '\0';
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, 2);
+}
+
+static ssize_t oa_tc6_trace_enable_write(struct file *file,
+					 const char __user *ubuf, size_t count,
+					 loff_t *ppos)
+{
+	struct oa_tc6 *tc6 = file->private_data;
+	struct oa_tc6_trace *trace = tc6->trace;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(ubuf, count, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&trace->buf_lock);
+	if (enable)
+		ret = oa_tc6_trace_start(tc6);
+	else
+		WRITE_ONCE(tc6->trace_enabled, false);
+	mutex_unlock(&trace->buf_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations oa_tc6_trace_enable_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = oa_tc6_trace_enable_read,
+	.write = oa_tc6_trace_enable_write,
+	.llseek = default_llseek,
+};
+
+static ssize_t oa_tc6_trace_read(struct file *file, char __user *ubuf,
+				 size_t count, loff_t *ppos)
+{
+	struct oa_tc6 *tc6 = file->private_data;
+	struct oa_tc6_trace *trace = tc6->trace;
+	ssize_t ret = 0;
+
+	mutex_lock(&trace->buf_lock);
+	if (trace->buf)
+		ret = simple_read_from_buffer(ubuf, count, ppos, trace->buf,
+					      OA_TC6_TRACE_DATA_OFFSET +
+					      trace->info->size);
+	mutex_unlock(&trace->buf_lock);
+
+	return ret;
+}
+
+static int oa_tc6_trace_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct oa_tc6 *tc6 = file->private_data;
+	struct oa_tc6_trace *trace = tc6->trace;
+	int ret = -ENODATA;
+
+	mutex_lock(&trace->buf_lock);
+	if (trace->buf)
+		ret = remap_vmalloc_range(vma, trace->buf, vma->vm_pgoff);
+	mutex_unlock(&trace->buf_lock);
+
+	return ret;
+}
+
+static const struct file_operations oa_tc6_trace_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = oa_tc6_trace_read,
+	.mmap = oa_tc6_trace_mmap,
+	.llseek = default_llseek,
+};
+
+void oa_tc6_trace_debugfs_init(struct oa_tc6 *tc6, struct dentry *dir)
+{
+	debugfs_create_file("trace_enable", 0600, dir, tc6,
+			    &oa_tc6_trace_enable_fops);
+	debugfs_create_u32("trace_size", 0600, dir, &tc6->trace->size);
+	debugfs_create_file("trace", 0400, dir, tc6, &oa_tc6_trace_fops);
+}
+
+int oa_tc6_trace_init(struct oa_tc6 *tc6)
+{
+	tc6->trace = kzalloc(sizeof(*tc6->trace), GFP_KERNEL);
+	if (!tc6->trace)
+		return -ENOMEM;
+
+	spin_lock_init(&tc6->trace->lock);
+	mutex_init(&tc6->trace->buf_lock);
+	tc6->trace->size = OA_TC6_TRACE_DEFAULT_SIZE;
+
+	return 0;
+}
+
+void oa_tc6_trace_deinit(struct oa_tc6 *tc6)
+{
+	tc6->trace_enabled = false;
+	vfree(tc6->trace->buf);
+	kfree(tc6->trace);
+}
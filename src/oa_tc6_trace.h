@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * OPEN Alliance 10BASE‑T1x MAC‑PHY Serial Interface SPI trace
+ *
+ * Raw SPI transfers are captured into a ring buffer which can be read or
+ * mmap'ed from debugfs. The layout below is shared with the replay tool in
+ * tools/oa_tc6.
+ *
+ * Author: Parthiban Veerasooran <parthiban.veerasooran@microchip.com>
+ */
+
+#ifndef _OA_TC6_TRACE_H
+#define _OA_TC6_TRACE_H
+
+#define OA_TC6_TRACE_MAGIC	0x54433654	/* "TC6T" */
+#define OA_TC6_TRACE_VERSION	1
+/* Offset of the record area from the start of the trace buffer */
+#define OA_TC6_TRACE_DATA_OFFSET	4096
+
+#define OA_TC6_TRACE_CTRL	0	/* Control transaction */
+#define OA_TC6_TRACE_DATA	1	/* Data chunks transfer */
+#define OA_TC6_TRACE_PAD	0xFF	/* Filler up to the end of the ring */
+
+/* Placed at the start of the trace buffer */
+struct oa_tc6_trace_info {
+	u32 magic;
+	u16 version;
+	u16 data_offset;
+	u32 size;	/* Size of the record area */
+	u32 head;	/* Offset where the next record will be written */
+	u32 tail;	/* Offset of the oldest record */
+	u32 used;	/* Bytes in use between tail and head */
+	u64 records;	/* Records captured since the trace was enabled */
+	u64 overwritten;	/* Oldest records lost to wrap around */
+};
+
+/* Each record is followed by len bytes of tx and len bytes of rx data and
+ * padded to 8 bytes. If less than a record header is left at the end of the
+ * ring, the writer wraps around without a PAD record.
+ */
+struct oa_tc6_trace_rec {
+	u64 ts_ns;	/* ktime_get_ns() at the start of the transfer */
+	u32 duration_ns;
+	u32 seq;
+	u32 size;	/* Size of this record including the header */
+	u16 len;	/* SPI transfer length */
+	u8 type;
+	u8 cps;
+};
+
+#define OA_TC6_TRACE_REC_SIZE(len) \
+	ALIGN(sizeof(struct oa_tc6_trace_rec) + 2 * (len), 8)
+
+#ifdef __KERNEL__
+struct oa_tc6;
+
+int oa_tc6_trace_init(struct oa_tc6 *tc6);
+void oa_tc6_trace_deinit(struct oa_tc6 *tc6);
+void oa_tc6_trace_debugfs_init(struct oa_tc6 *tc6, struct dentry *dir);
+void oa_tc6_trace_record(struct oa_tc6 *tc6, u8 *ptx, u8 *prx, u16 len,
+			 u64 ts_ns, u32 duration_ns);
+#endif
+
+#endif /* _OA_TC6_TRACE_H */
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Throughput benchmark of the OA TC6 framing core
+ *
+ * Usage: oa_tc6_bench [cps] [frame length] [iterations]
+ *
+ * Runs rx reassembly without and with checksumming and tx chunk preparation
+ * back to back for the given frame length, suitable for perf, cachegrind and
+ * the like.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include "oa_tc6_user.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double secs, unsigned long iters,
+		   u16 frame_len, u16 chunks)
+{
+	printf("%-4s %8.1f MB/s %10.0f frames/s %8.1f ns/chunk\n", name,
+	       (double)iters * frame_len / secs / 1e6, iters / secs,
+	       secs * 1e9 / ((double)iters * chunks));
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iters = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000000;
+	u16 frame_len = argc > 2 ? strtoul(argv[2], NULL, 0) : 1514;
+	u8 cps = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+	struct oa_tc6_user *user;
+	u8 frame[MAX_ETH_LEN];
+	u16 chunks;
+	u16 len;
+	double t;
+
+	if ((cps != 32 && cps != 64) || frame_len < ETH_HLEN ||
+	    frame_len > MAX_ETH_LEN) {
+		fprintf(stderr, "usage: %s [32|64] [%d..%d] [iterations]\n",
+			argv[0], ETH_HLEN, MAX_ETH_LEN);
+		return 1;
+	}
+
+	user = oa_tc6_user_alloc(cps, false);
+	if (!user)
+		return 1;
+
+	for (u16 i = 0; i < frame_len; i++)
+		frame[i] = i;
+	/* IPv4 UDP, so that the rx hash run takes the L4 path */
+	frame[12] = 0x08;
+	frame[13] = 0x00;
+	if (frame_len > ETH_HLEN + 20) {
+		frame[ETH_HLEN] = 0x45;
+		frame[ETH_HLEN + 6] = 0;
+		frame[ETH_HLEN + 7] = 0;
+		frame[ETH_HLEN + 9] = IPPROTO_UDP;
+	}
+	chunks = (frame_len + cps - 1) / cps;
+
+	len = oa_tc6_user_build_rx_stream(user->tc6.spi_rx_buf,
+					  OA_TC6_USER_SPI_BUF_SIZE, cps, frame,
+					  frame_len);
+	t = now();
+	for (unsigned long i = 0; i < iters; i++)
+		oa_tc6_process_rx_chunks(&user->tc6, user->tc6.spi_rx_buf, len);
+	report("rx", now() - t, iters, frame_len, chunks);
+
+	if (user->netdev.stats.rx_packets != iters) {
+		fprintf(stderr, "rx: %lu frames reassembled, expected %lu\n",
+			user->netdev.stats.rx_packets, iters);
+		return 1;
+	}
+
+	user->tc6.rx_csum_en = true;
+	t = now();
+	for (unsigned long i = 0; i < iters; i++)
+		oa_tc6_process_rx_chunks(&user->tc6, user->tc6.spi_rx_buf, len);
+	report("rxcs", now() - t, iters, frame_len, chunks);
+
+	if (user->tc6.rx_csum != csum_partial(frame, frame_len, 0)) {
+		fprintf(stderr, "rx: checksum %08x, expected %08x\n",
+			user->tc6.rx_csum, csum_partial(frame, frame_len, 0));
+		return 1;
+	}
+
+	user->tc6.rx_csum_en = false;
+	user->tc6.rx_hash_en = true;
+	t = now();
+	for (unsigned long i = 0; i < iters; i++)
+		oa_tc6_process_rx_chunks(&user->tc6, user->tc6.spi_rx_buf, len);
+	report("rxh", now() - t, iters, frame_len, chunks);
+
+	if (frame_len >= ETH_HLEN + 24 &&
+	    user->tc6.rx_hash_type != PKT_HASH_TYPE_L4) {
+		fprintf(stderr, "rx: hash type %u, expected L4\n",
+			user->tc6.rx_hash_type);
+		return 1;
+	}
+
+	t = now();
+	for (unsigned long i = 0; i < iters; i++)
+		oa_tc6_prepare_tx_chunks(&user->tc6, user->tc6.eth_tx_buf,
+					 frame, frame_len, 0);
+	report("tx", now() - t, iters, frame_len, chunks);
+
+	oa_tc6_user_free(user);
+	return 0;
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Standalone driver for the fuzz targets, for AFL and for replaying crash
+ * reproducers without libFuzzer: runs every file given on the command line,
+ * or stdin if there is none.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static int run_file(FILE *f)
+{
+	static uint8_t buf[1 << 20];
+	size_t size;
+
+	size = fread(buf, 1, sizeof(buf), f);
+	return LLVMFuzzerTestOneInput(buf, size);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+
+	if (argc < 2)
+		return run_file(stdin);
+
+	for (int i = 1; i < argc; i++) {
+		f = fopen(argv[i], "rb");
+		if (!f) {
+			perror(argv[i]);
+			return 1;
+		}
+		run_file(f);
+		fclose(f);
+	}
+
+	return 0;
+}
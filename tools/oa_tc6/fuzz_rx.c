@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * libFuzzer/AFL target for oa_tc6_process_rx_chunks()
+ *
+ * Input layout: one config byte followed by the raw SPI rx stream.
+ *   bit 0 - chunk payload size, 0 = 64 bytes, 1 = 32 bytes
+ *   bit 1 - repair footer parity before parsing
+ *   bits 7:4 - number of extra SPI transfers to split the stream into
+ */
+
+#include <stdlib.h>
+#include "oa_tc6_user.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct oa_tc6_user *user;
+	size_t split;
+	u16 xfer_len;
+	u16 chunk;
+	u16 len;
+	u8 cfg;
+	u8 cps;
+
+	if (size < 1)
+		return 0;
+
+	cfg = data[0];
+	data++;
+	size--;
+	cps = (cfg & BIT(0)) ? 32 : 64;
+
+	user = oa_tc6_user_alloc(cps, false);
+	if (!user)
+		return 0;
+
+	/* Never more than what oa_tc6_handler() hands over in one go */
+	chunk = cps + TC6_FTR_SIZE;
+	xfer_len = (OA_TC6_USER_SPI_BUF_SIZE / chunk) * chunk;
+	split = (cfg >> 4) ? size / ((cfg >> 4) + 1) / chunk * chunk : 0;
+	if (split >= chunk && split < xfer_len)
+		xfer_len = split;
+
+	while (size >= chunk) {
+		len = size < xfer_len ? size / chunk * chunk : xfer_len;
+		memcpy(user->tc6.spi_rx_buf, data, len);
+		if (cfg & BIT(1))
+			oa_tc6_user_fix_ftr_parity(user->tc6.spi_rx_buf, len,
+						   cps);
+		oa_tc6_process_rx_chunks(&user->tc6, user->tc6.spi_rx_buf,
+					 len);
+		data += len;
+		size -= len;
+	}
+
+	oa_tc6_user_free(user);
+	return 0;
+}
@@ -0,0 +1,3 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/* Userspace shim, see oa_tc6_shim.h */
+#include <oa_tc6_shim.h>
@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Minimal kernel API shims to build the OA TC6 framing core in userspace.
+ *
+ * Only what src/oa_tc6.h and src/oa_tc6_frame.c use is provided here. Kernel
+ * objects the framing core never touches are left as opaque types.
+ */
+
+#ifndef _OA_TC6_SHIM_H
+#define _OA_TC6_SHIM_H
+
+#include <endian.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#define BITS_PER_LONG		(8 * sizeof(long))
+#define BIT(nr)			(1UL << (nr))
+#define GENMASK(h, l) \
+	(((~0UL) << (l)) & (~0UL >> (BITS_PER_LONG - 1 - (h))))
+
+#define FIELD_PREP(mask, val) \
+	((((typeof(mask))(val)) << __builtin_ctzll(mask)) & (mask))
+#define FIELD_GET(mask, reg) \
+	((typeof(mask))(((reg) & (mask)) >> __builtin_ctzll(mask)))
+
+#define NSEC_PER_SEC		1000000000L
+
+#define ALIGN(x, a)		(((x) + (a) - 1) & ~((typeof(x))(a) - 1))
+
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+
+#define hweight32(x)		__builtin_popcount(x)
+
+#define cpu_to_be32(x)		htobe32(x)
+#define be32_to_cpu(x)		be32toh(x)
+
+/* Same results as the generic lib/checksum.c, not as fast */
+typedef u32 __wsum;
+
+static inline u32 csum_fold32(u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	return (sum & 0xffffffff) + (sum >> 32);
+}
+
+static inline __wsum csum_partial(const void *buff, int len, __wsum wsum)
+{
+	const u8 *p = buff;
+	u64 sum = wsum;
+	u16 word;
+
+	for (; len > 1; len -= 2, p += 2) {
+		memcpy(&word, p, 2);
+		sum += word;
+	}
+	if (len) {
+		word = 0;
+		memcpy(&word, p, 1);
+		sum += word;
+	}
+	return csum_fold32(sum);
+}
+
+static inline __wsum csum_partial_copy_nocheck(const void *src, void *dst,
+					       int len)
+{
+	memcpy(dst, src, len);
+	return csum_partial(dst, len, 0);
+}
+
+static inline __wsum csum_add(__wsum csum, __wsum addend)
+{
+	return csum_fold32((u64)csum + addend);
+}
+
+static inline __wsum csum_sub(__wsum csum, __wsum addend)
+{
+	return csum_add(csum, ~addend);
+}
+
+static inline __wsum csum_block_add(__wsum csum, __wsum csum2, int offset)
+{
+	if (offset & 1)
+		csum2 = (csum2 >> 8) | (csum2 << 24);
+	return csum_add(csum, csum2);
+}
+
+#ifdef OA_TC6_SHIM_VERBOSE
+#define netdev_err(ndev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define netdev_warn(ndev, fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#else
+#define netdev_err(ndev, fmt, ...) \
+	do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define netdev_warn(ndev, fmt, ...) \
+	do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#endif
+
+typedef enum {
+	NETDEV_TX_OK = 0x00,
+	NETDEV_TX_BUSY = 0x10,
+} netdev_tx_t;
+
+struct net_device_stats {
+	unsigned long rx_packets;
+	unsigned long tx_packets;
+	unsigned long rx_bytes;
+	unsigned long tx_bytes;
+	unsigned long rx_errors;
+	unsigned long tx_errors;
+	unsigned long rx_dropped;
+	unsigned long tx_dropped;
+	unsigned long rx_length_errors;
+};
+
+struct net_device {
+	struct net_device_stats stats;
+};
+
+struct sk_buff {
+	unsigned char *data;
+	unsigned int len;
+};
+
+struct sk_buff_head {
+	struct sk_buff *next;
+	struct sk_buff *prev;
+	u32 qlen;
+	int lock;
+};
+
+struct completion {
+	unsigned int done;
+};
+
+typedef struct {
+	int dummy;
+} wait_queue_head_t;
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+struct hrtimer {
+	int dummy;
+};
+
+#define VLAN_HLEN		4
+
+enum pkt_hash_types {
+	PKT_HASH_TYPE_NONE,
+	PKT_HASH_TYPE_L2,
+	PKT_HASH_TYPE_L3,
+	PKT_HASH_TYPE_L4,
+};
+
+static inline bool ip_is_fragment(const struct iphdr *iph)
+{
+	return (iph->frag_off & htons(0x2000 | 0x1fff)) != 0;	/* MF, offset */
+}
+
+static inline u32 ipv6_addr_hash(const struct in6_addr *a)
+{
+	return a->s6_addr32[0] ^ a->s6_addr32[1] ^
+	       a->s6_addr32[2] ^ a->s6_addr32[3];
+}
+
+/* Same as include/linux/jhash.h */
+static inline u32 rol32(u32 word, unsigned int shift)
+{
+	return (word << shift) | (word >> ((-shift) & 31));
+}
+
+static inline u32 jhash_3words(u32 a, u32 b, u32 c, u32 initval)
+{
+	initval += 0xdeadbeef + (3 << 2);
+	a += initval;
+	b += initval;
+	c += initval;
+	c ^= b; c -= rol32(b, 14);
+	a ^= c; a -= rol32(c, 11);
+	b ^= a; b -= rol32(a, 25);
+	c ^= b; c -= rol32(b, 16);
+	a ^= c; a -= rol32(c, 4);
+	b ^= a; b -= rol32(a, 14);
+	c ^= b; c -= rol32(b, 24);
+	return c;
+}
+
+struct task_struct;
+struct ifreq;
+struct spi_device;
+struct dentry;
+struct device_node;
+
+#endif /* _OA_TC6_SHIM_H */
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Userspace harness around the OA TC6 framing core
+ */
+
+#include <stdlib.h>
+#include <linux/bitfield.h>
+#include "oa_tc6_user.h"
+
+void oa_tc6_rx_eth_ready(struct oa_tc6 *tc6)
+{
+	tc6->netdev->stats.rx_packets++;
+	tc6->netdev->stats.rx_bytes += tc6->rxd_bytes;
+}
+
+int oa_tc6_process_exst(struct oa_tc6 *tc6)
+{
+	struct oa_tc6_user *user = (struct oa_tc6_user *)tc6;
+
+	user->exst_count++;
+	tc6->rx_err = OA_TC6_ERR_STATUS;
+	return FTR_ERR;
+}
+
+struct oa_tc6_user *oa_tc6_user_alloc(u8 cps, bool ctrl_prot)
+{
+	struct oa_tc6_user *user;
+
+	user = calloc(1, sizeof(*user));
+	if (!user)
+		return NULL;
+
+	user->tc6.netdev = &user->netdev;
+	user->tc6.cps = cps;
+	oa_tc6_select_chunk_ops(&user->tc6);
+	user->tc6.ctrl_prot = ctrl_prot;
+	/* Same sizes as oa_tc6_init() so that the sanitizers catch exactly the
+	 * overflows the kernel would suffer from. The SPI buffers leave out the
+	 * rounding up to whole cachelines, which is not usable space.
+	 */
+	user->tc6.spi_tx_buf = calloc(1, OA_TC6_USER_SPI_BUF_SIZE);
+	user->tc6.spi_rx_buf = calloc(1, OA_TC6_USER_SPI_BUF_SIZE);
+	user->tc6.eth_tx_buf = calloc(1, MAX_ETH_LEN +
+					 (OA_TC6_MAX_CPS * TC6_HDR_SIZE));
+	user->tc6.eth_rx_buf = calloc(1, MAX_ETH_LEN +
+					 (OA_TC6_MAX_CPS * TC6_FTR_SIZE));
+	if (!user->tc6.spi_tx_buf || !user->tc6.spi_rx_buf ||
+	    !user->tc6.eth_tx_buf || !user->tc6.eth_rx_buf) {
+		oa_tc6_user_free(user);
+		return NULL;
+	}
+
+	return user;
+}
+
+void oa_tc6_user_free(struct oa_tc6_user *user)
+{
+	free(user->tc6.spi_tx_buf);
+	free(user->tc6.spi_rx_buf);
+	free(user->tc6.eth_tx_buf);
+	free(user->tc6.eth_rx_buf);
+	free(user);
+}
+
+/* Fuzzers almost never hit a correct odd parity by chance, so optionally
+ * repair it to get past the parity check into the reassembly logic.
+ */
+void oa_tc6_user_fix_ftr_parity(u8 *buf, u16 len, u8 cps)
+{
+	u16 cp_count = len / (cps + TC6_FTR_SIZE);
+	u32 ftr;
+
+	for (u16 i = 0; i < cp_count; i++) {
+		u8 *p = &buf[cps + (i * (cps + TC6_FTR_SIZE))];
+
+		memcpy(&ftr, p, sizeof(ftr));
+		ftr = be32_to_cpu(ftr) & ~DATA_FTR_P;
+		ftr |= FIELD_PREP(DATA_FTR_P, oa_tc6_get_parity(ftr));
+		ftr = cpu_to_be32(ftr);
+		memcpy(p, &ftr, sizeof(ftr));
+	}
+}
+
+/* Build the chunk stream a MAC-PHY would send for one received frame, used
+ * by the benchmarks. Returns the number of bytes written into buf.
+ */
+u16 oa_tc6_user_build_rx_stream(u8 *buf, u16 size, u8 cps,
+				const u8 *frame, u16 frame_len)
+{
+	u16 cp_count = (frame_len + cps - 1) / cps;
+	u16 copied = 0;
+	u32 ftr;
+
+	if (cp_count * (cps + TC6_FTR_SIZE) > size)
+		return 0;
+
+	for (u16 i = 0; i < cp_count; i++) {
+		u16 copy_len = frame_len - copied < cps ? frame_len - copied : cps;
+		u8 *payload = &buf[i * (cps + TC6_FTR_SIZE)];
+
+		memcpy(payload, &frame[copied], copy_len);
+		memset(&payload[copy_len], 0, cps - copy_len);
+		ftr = FIELD_PREP(DATA_FTR_SYNC, 1) |
+		      FIELD_PREP(DATA_FTR_DV, 1) |
+		      FIELD_PREP(DATA_FTR_TXC, 31);
+		if (!i)
+			ftr |= FIELD_PREP(DATA_FTR_SV, 1);
+		copied += copy_len;
+		if (copied == frame_len)
+			ftr |= FIELD_PREP(DATA_FTR_EV, 1) |
+			       FIELD_PREP(DATA_FTR_EBO, copy_len - 1);
+		ftr |= FIELD_PREP(DATA_FTR_P, oa_tc6_get_parity(ftr));
+		ftr = cpu_to_be32(ftr);
+		memcpy(&payload[cps], &ftr, sizeof(ftr));
+	}
+
+	return cp_count * (cps + TC6_FTR_SIZE);
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Userspace harness around the OA TC6 framing core
+ */
+
+#ifndef _OA_TC6_USER_H
+#define _OA_TC6_USER_H
+
+#include "oa_tc6_frame.h"
+
+#define OA_TC6_USER_SPI_BUF_SIZE	OA_TC6_SPI_BUF_SIZE
+
+struct oa_tc6_user {
+	struct oa_tc6 tc6;
+	struct net_device netdev;
+	unsigned long exst_count;
+};
+
+struct oa_tc6_user *oa_tc6_user_alloc(u8 cps, bool ctrl_prot);
+void oa_tc6_user_free(struct oa_tc6_user *user);
+void oa_tc6_user_fix_ftr_parity(u8 *buf, u16 len, u8 cps);
+u16 oa_tc6_user_build_rx_stream(u8 *buf, u16 size, u8 cps,
+				const u8 *frame, u16 frame_len);
+
+#endif /* _OA_TC6_USER_H */
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Replay of captured OA TC6 SPI traces through the rx chunk parser
+ *
+ * Usage: oa_tc6_replay [-l loops] [-v] trace.bin
+ *
+ * trace.bin is a copy of the debugfs trace file of a device, e.g.
+ *   echo 1 > /sys/kernel/debug/oa_tc6-spi0.0/trace_enable
+ *   ...
+ *   echo 0 > /sys/kernel/debug/oa_tc6-spi0.0/trace_enable
+ *   cat /sys/kernel/debug/oa_tc6-spi0.0/trace > trace.bin
+ *
+ * The rx side of every data transfer is fed to oa_tc6_process_rx_chunks() in
+ * capture order, as fast as possible, loops times.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "oa_tc6_user.h"
+#include "oa_tc6_trace.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static u8 *read_file(const char *path, size_t *size)
+{
+	size_t alloc = 1 << 20;
+	u8 *buf = NULL;
+	size_t n = 0;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+
+	do {
+		alloc *= 2;
+		buf = realloc(buf, alloc);
+		if (!buf)
+			break;
+		n += fread(&buf[n], 1, alloc - n, f);
+	} while (n == alloc);
+
+	fclose(f);
+	*size = n;
+	return buf;
+}
+
+int main(int argc, char **argv)
+{
+	struct oa_tc6_trace_rec **recs;
+	struct oa_tc6_trace_info *info;
+	unsigned long loops = 1;
+	struct oa_tc6_user *user;
+	unsigned long n_recs = 0;
+	unsigned long n_ctrl = 0;
+	unsigned long errors = 0;
+	u64 rx_spi_bytes = 0;
+	bool verbose = false;
+	u32 left, off;
+	size_t size;
+	double t;
+	u8 *buf;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:v")) != -1) {
+		switch (opt) {
+		case 'l':
+			loops = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1)
+		goto usage;
+
+	buf = read_file(argv[optind], &size);
+	if (!buf)
+		return 1;
+
+	info = (struct oa_tc6_trace_info *)buf;
+	if (size < OA_TC6_TRACE_DATA_OFFSET || info->magic != OA_TC6_TRACE_MAGIC ||
+	    info->version != OA_TC6_TRACE_VERSION ||
+	    size < (size_t)info->data_offset + info->size) {
+		fprintf(stderr, "%s: not an OA TC6 trace\n", argv[optind]);
+		return 1;
+	}
+
+	recs = calloc(info->used / sizeof(**recs) + 1, sizeof(*recs));
+	if (!recs)
+		return 1;
+
+	/* Walk the ring from the oldest record */
+	off = info->tail;
+	left = info->used;
+	while (left) {
+		u8 *data = &buf[info->data_offset];
+		struct oa_tc6_trace_rec *rec;
+
+		if (info->size - off < sizeof(*rec)) {
+			left -= info->size - off;
+			off = 0;
+			continue;
+		}
+		rec = (struct oa_tc6_trace_rec *)&data[off];
+		if (!rec->size || rec->size > left) {
+			fprintf(stderr, "corrupt record at offset %u\n", off);
+			break;
+		}
+		if (verbose && rec->type != OA_TC6_TRACE_PAD)
+			printf("%10u %20llu %8u ns %-4s %5u bytes cps %u\n",
+			       rec->seq, (unsigned long long)rec->ts_ns,
+			       rec->duration_ns,
+			       rec->type == OA_TC6_TRACE_DATA ? "data" : "ctrl",
+			       rec->len, rec->cps);
+		if (rec->type == OA_TC6_TRACE_DATA &&
+		    (rec->cps == 32 || rec->cps == 64) &&
+		    rec->len <= OA_TC6_USER_SPI_BUF_SIZE) {
+			recs[n_recs++] = rec;
+			rx_spi_bytes += rec->len;
+		} else if (rec->type == OA_TC6_TRACE_CTRL) {
+			n_ctrl++;
+		}
+		off += rec->size;
+		left -= rec->size;
+		if (off == info->size)
+			off = 0;
+	}
+
+	if (!n_recs) {
+		fprintf(stderr, "no data transfers in the trace\n");
+		return 1;
+	}
+
+	user = oa_tc6_user_alloc(recs[0]->cps, false);
+	if (!user)
+		return 1;
+
+	t = now();
+	for (unsigned long l = 0; l < loops; l++) {
+		for (unsigned long i = 0; i < n_recs; i++) {
+			struct oa_tc6_trace_rec *rec = recs[i];
+
+			user->tc6.cps = rec->cps;
+			oa_tc6_select_chunk_ops(&user->tc6);
+			memcpy(user->tc6.spi_rx_buf,
+			       (u8 *)(rec + 1) + rec->len, rec->len);
+			if (oa_tc6_process_rx_chunks(&user->tc6,
+						     user->tc6.spi_rx_buf,
+						     rec->len))
+				errors++;
+		}
+	}
+	t = now() - t;
+
+	printf("records: %llu captured, %llu overwritten, %lu data, %lu ctrl\n",
+	       (unsigned long long)info->records,
+	       (unsigned long long)info->overwritten, n_recs, n_ctrl);
+	printf("frames: %lu, bytes: %lu, dropped: %lu, length errors: %lu\n",
+	       user->netdev.stats.rx_packets / loops,
+	       user->netdev.stats.rx_bytes / loops,
+	       user->netdev.stats.rx_dropped / loops,
+	       user->netdev.stats.rx_length_errors / loops);
+	printf("footer errors: %lu, extended status: %lu\n", errors / loops,
+	       user->exst_count / loops);
+	printf("parser: %.1f MB/s of SPI rx data, %.0f frames/s\n",
+	       rx_spi_bytes * loops / t / 1e6,
+	       user->netdev.stats.rx_packets / t);
+
+	oa_tc6_user_free(user);
+	free(recs);
+	free(buf);
+	return 0;
+
+usage:
+	fprintf(stderr, "usage: %s [-l loops] [-v] trace.bin\n", argv[0]);
+	return 1;
+}